@@ -1,25 +1,47 @@
+from tf_big.python.tensor import FixedBaseTable
+from tf_big.python.tensor import ObfuscatorPool
 from tf_big.python.tensor import Tensor
 from tf_big.python.tensor import add
+from tf_big.python.tensor import concat
 from tf_big.python.tensor import constant
 from tf_big.python.tensor import export_limbs_tensor
 from tf_big.python.tensor import export_tensor
+from tf_big.python.tensor import from_montgomery
+from tf_big.python.tensor import gather
 from tf_big.python.tensor import get_secure_default
+from tf_big.python.tensor import gmp_memory_stats
 from tf_big.python.tensor import import_limbs_tensor
 from tf_big.python.tensor import import_tensor
 from tf_big.python.tensor import inv
+from tf_big.python.tensor import kernel_counters
 from tf_big.python.tensor import matmul
 from tf_big.python.tensor import mod
+from tf_big.python.tensor import montgomery_add
+from tf_big.python.tensor import montgomery_mul
+from tf_big.python.tensor import montgomery_pow
+from tf_big.python.tensor import montgomery_sub
 from tf_big.python.tensor import mul
 from tf_big.python.tensor import pow
+from tf_big.python.tensor import pow_crt
 from tf_big.python.tensor import random_rsa_modulus
 from tf_big.python.tensor import random_uniform
+from tf_big.python.tensor import reduce_prod_mod
+from tf_big.python.tensor import reduce_sum
+from tf_big.python.tensor import reshape
 from tf_big.python.tensor import set_secure_default
+from tf_big.python.tensor import slice
 from tf_big.python.tensor import sub
+from tf_big.python.tensor import to_montgomery
+from tf_big.python.tensor import transpose
 
 __all__ = [
     "set_secure_default",
     "get_secure_default",
     "Tensor",
+    "FixedBaseTable",
+    "ObfuscatorPool",
+    "kernel_counters",
+    "gmp_memory_stats",
     "constant",
     "export_limbs_tensor",
     "export_tensor",
@@ -31,7 +53,21 @@ __all__ = [
     "sub",
     "mul",
     "pow",
+    "pow_crt",
     "matmul",
     "mod",
     "inv",
+    "reduce_sum",
+    "reduce_prod_mod",
+    "slice",
+    "gather",
+    "concat",
+    "reshape",
+    "transpose",
+    "to_montgomery",
+    "from_montgomery",
+    "montgomery_mul",
+    "montgomery_add",
+    "montgomery_sub",
+    "montgomery_pow",
 ]
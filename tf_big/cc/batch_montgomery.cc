@@ -0,0 +1,341 @@
+#include "tf_big/cc/batch_montgomery.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "tf_big/cc/montgomery.h"
+
+namespace tf_big {
+
+namespace {
+
+// As for MontgomeryContext::Get.
+const size_t kMaxCachedEngines = 64;
+
+// Vector loads are fastest from whole cache lines.
+const uintptr_t kAlignment = 64;
+
+// Returns `size` words of `buffer` starting at a kAlignment boundary, growing
+// the buffer as needed.
+uint64_t* AlignedWords(std::vector<uint64_t>* buffer, size_t size) {
+  size_t slack = kAlignment / sizeof(uint64_t) - 1;
+  if (buffer->size() < size + slack) {
+    buffer->resize(size + slack);
+  }
+  uintptr_t address = reinterpret_cast<uintptr_t>(buffer->data());
+  return reinterpret_cast<uint64_t*>((address + kAlignment - 1) &
+                                     ~(kAlignment - 1));
+}
+
+// Writes the value in `src` as k limbs of w bits to dst[0], dst[stride], ...
+void SplitLimbs(const mp_limb_t* src, mp_size_t size, int w, int k,
+                uint64_t* dst, int stride) {
+  uint64_t mask = (uint64_t(1) << w) - 1;
+  for (int j = 0; j < k; j++) {
+    size_t bit = size_t(j) * w;
+    mp_size_t limb = bit / GMP_NUMB_BITS;
+    int shift = bit % GMP_NUMB_BITS;
+    uint64_t value = 0;
+    if (limb < size) {
+      value = src[limb] >> shift;
+      if (shift + w > GMP_NUMB_BITS && limb + 1 < size) {
+        value |= src[limb + 1] << (GMP_NUMB_BITS - shift);
+      }
+    }
+    dst[j * stride] = value & mask;
+  }
+}
+
+// The portable reference: a single lane of 32-bit limbs, with products split
+// into halves as with IFMA. It is slower than GMP and only used when forced.
+struct Scalar {
+  typedef uint64_t V;
+  static const int kLanes = 1;
+  static const int kBits = 32;
+  static const bool kSplitProducts = true;
+
+  static V Load(const uint64_t* p) { return *p; }
+  static void Store(uint64_t* p, V x) { *p = x; }
+  static V Zero() { return 0; }
+  static V Add(V x, V y) { return x + y; }
+  static V Shr(V x) { return x >> kBits; }
+  static V Mask(V x) { return x & 0xffffffff; }
+  static void MulAdd(V* lo, V* hi, V a, V b) {
+    V product = a * b;
+    *lo += Mask(product);
+    *hi += Shr(product);
+  }
+  static V Quotient(V x, V ninv) { return Mask(x * ninv); }
+};
+
+void ScalarMul(uint64_t* rp, const uint64_t* ap, const uint64_t* bp,
+               const uint64_t* np, const uint64_t* ninvp, int k,
+               uint64_t* tp) {
+  BatchMontgomeryMul<Scalar>(rp, ap, bp, np, ninvp, k, tp);
+}
+
+}  // namespace
+
+const BatchKernels* ScalarBatchKernels() {
+  static const BatchKernels kernels = {
+      "scalar", Scalar::kLanes, Scalar::kBits, kNeverFaster, kNeverFaster,
+      ScalarMul};
+  return &kernels;
+}
+
+BatchMontgomery::Workspace::Workspace() { mpz_init(tmp_); }
+
+BatchMontgomery::Workspace::~Workspace() { mpz_clear(tmp_); }
+
+uint64_t* BatchMontgomery::Workspace::Get(size_t size) {
+  return AlignedWords(&buffer_, size);
+}
+
+const BatchKernels* BatchMontgomery::SelectKernels(const char* isa,
+                                                   bool* forced) {
+  *forced = false;
+#if GMP_NUMB_BITS == 64 && GMP_NAIL_BITS == 0
+  const BatchKernels* candidates[] = {
+      Avx512IfmaBatchKernels(),
+      Avx2BatchKernels(),
+      ScalarBatchKernels(),
+  };
+  if (isa != nullptr && *isa != '\0') {
+    if (std::strcmp(isa, "none") == 0) {
+      *forced = true;
+      return nullptr;
+    }
+    for (const BatchKernels* kernels : candidates) {
+      if (kernels != nullptr && std::strcmp(isa, kernels->name) == 0) {
+        *forced = true;
+        return kernels;
+      }
+    }
+    std::fprintf(stderr,
+                 "tf_big: ignoring TF_BIG_BATCH_ISA=%s, which is not an "
+                 "instruction set supported on this CPU\n",
+                 isa);
+  }
+  for (const BatchKernels* kernels : candidates) {
+    if (kernels != nullptr) {
+      return kernels;
+    }
+  }
+#endif
+  return nullptr;
+}
+
+std::shared_ptr<const BatchMontgomery> BatchMontgomery::Get(
+    mpz_srcptr modulus, Operation op) {
+  // `forced` is set while initializing `selected`, once for all threads.
+  static bool forced;
+  static const BatchKernels* const selected =
+      SelectKernels(std::getenv("TF_BIG_BATCH_ISA"), &forced);
+  if (selected == nullptr || mpz_cmp_ui(modulus, 3) < 0 ||
+      mpz_even_p(modulus)) {
+    return nullptr;
+  }
+  size_t bits = mpz_sizeinbase(modulus, 2);
+  int min_bits = op == kMul ? selected->min_mul_bits : selected->min_pow_bits;
+  if (bits > kMaxBits || (!forced && bits < size_t(min_bits))) {
+    return nullptr;
+  }
+
+  static std::mutex mu;
+  static std::unordered_map<std::string,
+                            std::shared_ptr<const BatchMontgomery>>
+      cache;
+
+  std::string key(reinterpret_cast<const char*>(mpz_limbs_read(modulus)),
+                  mpz_size(modulus) * sizeof(mp_limb_t));
+
+  std::lock_guard<std::mutex> lock(mu);
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    return it->second;
+  }
+  if (cache.size() >= kMaxCachedEngines) {
+    cache.clear();
+  }
+  std::shared_ptr<const BatchMontgomery> engine(
+      new BatchMontgomery(modulus, *selected));
+  cache.emplace(std::move(key), engine);
+  return engine;
+}
+
+BatchMontgomery::BatchMontgomery(mpz_srcptr modulus,
+                                 const BatchKernels& kernels)
+    : kernels_(kernels) {
+  mpz_init_set(modulus_, modulus);
+  int w = kernels_.limb_bits;
+  k_ = (mpz_sizeinbase(modulus_, 2) + 2 + w - 1) / w;
+
+  size_t batch = size_t(k_) * lanes();
+  uint64_t* n = AlignedWords(&constants_, 4 * batch + lanes());
+  uint64_t* r = n + batch;
+  uint64_t* r2 = r + batch;
+  uint64_t* one = r2 + batch;
+  uint64_t* ninv = one + batch;
+
+  mpz_t value;
+  mpz_init_set(value, modulus_);
+  auto broadcast = [&](uint64_t* dst) {
+    for (int l = 0; l < lanes(); l++) {
+      SplitLimbs(mpz_limbs_read(value), mpz_size(value), w, k_, dst + l,
+                 lanes());
+    }
+  };
+
+  broadcast(n);
+  mpz_set_ui(value, 0);
+  mpz_setbit(value, w * k_);
+  mpz_mod(value, value, modulus_);
+  broadcast(r);
+  mpz_mul(value, value, value);
+  mpz_mod(value, value, modulus_);
+  broadcast(r2);
+  mpz_set_ui(value, 1);
+  broadcast(one);
+
+  // -N^-1 mod 2^w, which the kernels only need as a single limb.
+  mpz_t base;
+  mpz_init(base);
+  mpz_setbit(base, w);
+  mpz_invert(value, modulus_, base);
+  mpz_sub(value, base, value);
+  std::fill(ninv, ninv + lanes(), mpz_get_ui(value));
+  mpz_clear(base);
+  mpz_clear(value);
+
+  n_ = n;
+  r_ = r;
+  r2_ = r2;
+  one_ = one;
+  ninv_ = ninv;
+}
+
+BatchMontgomery::~BatchMontgomery() { mpz_clear(modulus_); }
+
+void BatchMontgomery::Load(uint64_t* dst, int lane, mpz_srcptr x,
+                           mpz_ptr tmp) const {
+  if (mpz_sgn(x) < 0 || mpz_cmp(x, modulus_) >= 0) {
+    mpz_mod(tmp, x, modulus_);
+    x = tmp;
+  }
+  SplitLimbs(mpz_limbs_read(x), mpz_size(x), kernels_.limb_bits, k_,
+             dst + lane, lanes());
+}
+
+void BatchMontgomery::Store(mpz_ptr r, const uint64_t* src, int lane) const {
+  int w = kernels_.limb_bits;
+  mp_size_t size = (size_t(w) * k_ + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+  mp_limb_t* rp = mpz_limbs_write(r, size);
+  std::fill(rp, rp + size, 0);
+  for (int j = 0; j < k_; j++) {
+    mp_limb_t value = src[j * lanes() + lane];
+    size_t bit = size_t(j) * w;
+    mp_size_t limb = bit / GMP_NUMB_BITS;
+    int shift = bit % GMP_NUMB_BITS;
+    rp[limb] |= value << shift;
+    if (shift + w > GMP_NUMB_BITS) {
+      rp[limb + 1] |= value >> (GMP_NUMB_BITS - shift);
+    }
+  }
+  mpz_limbs_finish(r, size);
+  if (mpz_cmp(r, modulus_) >= 0) {
+    mpz_sub(r, r, modulus_);
+  }
+}
+
+void BatchMontgomery::Mul(mpz_ptr const* r, const mpz_srcptr* x,
+                          const mpz_srcptr* y, int count,
+                          Workspace* ws) const {
+  size_t batch = size_t(k_) * lanes();
+  uint64_t* a = ws->Get(4 * batch);
+  uint64_t* b = a + batch;
+  uint64_t* t = b + batch;
+  uint64_t* tp = t + batch;
+
+  std::fill(a, a + 2 * batch, 0);
+  for (int l = 0; l < count; l++) {
+    Load(a, l, x[l], ws->tmp());
+    Load(b, l, y[l], ws->tmp());
+  }
+
+  // (a b R^-1) R^2 R^-1 = a b
+  MontMul(t, a, b, tp);
+  MontMul(t, t, r2_, tp);
+
+  for (int l = 0; l < count; l++) {
+    Store(r[l], t, l);
+  }
+}
+
+void BatchMontgomery::Pow(mpz_ptr const* r, const mpz_srcptr* b,
+                          const mpz_srcptr* e, int count,
+                          Workspace* ws) const {
+  size_t bits = 0;
+  for (int l = 0; l < count; l++) {
+    if (mpz_sgn(e[l]) > 0) {
+      bits = std::max(bits, mpz_sizeinbase(e[l], 2));
+    }
+  }
+
+  int window = PowWindowSize(bits);
+  size_t table_size = size_t(1) << window;
+  size_t batch = size_t(k_) * lanes();
+  uint64_t* table = ws->Get((table_size + 3) * batch);
+  uint64_t* acc = table + table_size * batch;
+  uint64_t* sel = acc + batch;
+  uint64_t* tp = sel + batch;
+
+  // table[d] = b^d R, with unused lanes left at zero.
+  std::fill(sel, sel + batch, 0);
+  for (int l = 0; l < count; l++) {
+    Load(sel, l, b[l], ws->tmp());
+  }
+  std::copy(r_, r_ + batch, table);
+  MontMul(table + batch, sel, r2_, tp);
+  for (size_t d = 2; d < table_size; d++) {
+    MontMul(table + d * batch, table + (d - 1) * batch, table + batch, tp);
+  }
+
+  // Left-to-right over windows of the longest exponent as in
+  // MontgomeryContext::Pow, except that every lane multiplies by the table
+  // entry of its own digit, the entry for zero being one.
+  std::copy(r_, r_ + batch, acc);
+  size_t num_windows = (bits + window - 1) / window;
+  for (size_t w = num_windows; w-- > 0;) {
+    for (int l = 0; l < lanes(); l++) {
+      size_t digit = 0;
+      for (int i = window - 1; l < count && i >= 0; i--) {
+        digit = (digit << 1) | mpz_tstbit(e[l], w * window + i);
+      }
+      const uint64_t* entry = table + digit * batch;
+      for (int j = 0; j < k_; j++) {
+        sel[j * lanes() + l] = entry[j * lanes() + l];
+      }
+    }
+
+    if (w == num_windows - 1) {
+      std::copy(sel, sel + batch, acc);
+      continue;
+    }
+    for (int i = 0; i < window; i++) {
+      MontMul(acc, acc, acc, tp);
+    }
+    MontMul(acc, acc, sel, tp);
+  }
+
+  MontMul(acc, acc, one_, tp);
+  for (int l = 0; l < count; l++) {
+    Store(r[l], acc, l);
+  }
+}
+
+}  // namespace tf_big
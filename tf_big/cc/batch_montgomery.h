@@ -0,0 +1,122 @@
+#ifndef TF_BIG_CC_BATCH_MONTGOMERY_H_
+#define TF_BIG_CC_BATCH_MONTGOMERY_H_
+
+#include <gmp.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tf_big/cc/batch_montgomery_kernels.h"
+
+namespace tf_big {
+
+// Modular multiplication and exponentiation on batches of values sharing one
+// odd modulus N, vectorized across the batch: SIMD lane l works on value l,
+// so up to lanes() values cost the instruction stream of a single one.
+//
+// Values are split into W-bit limbs, 52 bits with AVX-512 IFMA and 27 with
+// AVX2, and multiplied with almost-Montgomery multiplication for
+// R = 2^(W k) >= 4N, which keeps intermediates in [0, 2N) without the
+// data-dependent final subtraction that lanes could not agree on. The
+// Montgomery domain is internal; inputs and results are ordinary integers.
+class BatchMontgomery {
+ public:
+  static const int kMaxLanes = 8;
+
+  // Largest supported modulus, within the accumulator headroom of every
+  // instruction set.
+  static const int kMaxBits = 8192;
+
+  // Per-thread scratch space, reusable across calls and moduli.
+  class Workspace {
+   public:
+    Workspace();
+    ~Workspace();
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    // Returns `size` words aligned for vector loads, valid until the next
+    // call.
+    uint64_t* Get(size_t size);
+
+    mpz_ptr tmp() { return tmp_; }
+
+   private:
+    std::vector<uint64_t> buffer_;
+    mpz_t tmp_;
+  };
+
+  // Operations whose break-even modulus size differs.
+  enum Operation { kMul, kPow };
+
+  // Returns an engine for `modulus` on the best instruction set of this CPU,
+  // reusing a previously built one when the same modulus has been seen
+  // recently. Returns nullptr when batching is not expected to beat GMP for
+  // `op`: on CPUs without a suitable vector unit, and for moduli that are
+  // even, below three, smaller than the instruction set's break-even size or
+  // larger than kMaxBits. Setting TF_BIG_BATCH_ISA to "none", "scalar",
+  // "avx2" or "avx512ifma" forces an instruction set regardless of the
+  // modulus size; other values, and instruction sets that this CPU does not
+  // support, are ignored with a warning. Thread-safe.
+  static std::shared_ptr<const BatchMontgomery> Get(mpz_srcptr modulus,
+                                                    Operation op);
+
+  // The kernels Get uses when TF_BIG_BATCH_ISA is set to `isa`, or unset if
+  // `isa` is null, and whether `isa` forced them. Exposed for testing.
+  static const BatchKernels* SelectKernels(const char* isa, bool* forced);
+
+  // `modulus` must be odd, at least three and at most kMaxBits bits.
+  BatchMontgomery(mpz_srcptr modulus, const BatchKernels& kernels);
+  ~BatchMontgomery();
+
+  BatchMontgomery(const BatchMontgomery&) = delete;
+  BatchMontgomery& operator=(const BatchMontgomery&) = delete;
+
+  const BatchKernels& kernels() const { return kernels_; }
+
+  // Number of values processed together.
+  int lanes() const { return kernels_.lanes; }
+
+  // r[l] = x[l] y[l] mod N for l < count <= lanes(), for inputs of any sign
+  // and size. Results may alias inputs.
+  void Mul(mpz_ptr const* r, const mpz_srcptr* x, const mpz_srcptr* y,
+           int count, Workspace* ws) const;
+
+  // r[l] = b[l]^e[l] mod N for l < count <= lanes(), for non-negative
+  // exponents, using a fixed window sized from the longest exponent. Results
+  // may alias inputs.
+  void Pow(mpz_ptr const* r, const mpz_srcptr* b, const mpz_srcptr* e,
+           int count, Workspace* ws) const;
+
+ private:
+  // Writes x mod N into `lane` of the batch at `dst`.
+  void Load(uint64_t* dst, int lane, mpz_srcptr x, mpz_ptr tmp) const;
+
+  // r = the value in `lane` of the batch at `src`, which is below 2N, mod N.
+  void Store(mpz_ptr r, const uint64_t* src, int lane) const;
+
+  // rp = a b R^-1 mod N for batches below 2N.
+  void MontMul(uint64_t* rp, const uint64_t* ap, const uint64_t* bp,
+               uint64_t* tp) const {
+    kernels_.mul(rp, ap, bp, n_, ninv_, k_, tp);
+  }
+
+  const BatchKernels& kernels_;
+  mpz_t modulus_;
+  // Limbs per value.
+  int k_;
+  // Batches holding the same value in every lane: N, -N^-1 mod 2^W, R mod N,
+  // R^2 mod N and one, all pointing into `constants_`.
+  std::vector<uint64_t> constants_;
+  const uint64_t* n_;
+  const uint64_t* ninv_;
+  const uint64_t* r_;
+  const uint64_t* r2_;
+  const uint64_t* one_;
+};
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_BATCH_MONTGOMERY_H_
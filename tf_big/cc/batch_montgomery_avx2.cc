@@ -0,0 +1,95 @@
+// AVX2 kernels, compiled for that target function by function so that the
+// rest of the library keeps running on CPUs without it.
+
+#include <cstdint>
+
+#if defined(__x86_64__) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7))
+#define TF_BIG_BATCH_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if TF_BIG_BATCH_AVX2
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), \
+                             apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#endif
+
+#include "tf_big/cc/batch_montgomery_kernels.h"
+
+namespace tf_big {
+
+#if TF_BIG_BATCH_AVX2
+
+namespace {
+
+// Four lanes of 27-bit limbs multiplied by vpmuludq, which takes the low 32
+// bits of each lane and returns the full 64-bit product. Products are
+// accumulated whole, so a column of 2k products of up to 2^54 fits in 64 bits
+// for k < 512, i.e. moduli of up to 13,800 bits.
+struct Avx2 {
+  typedef __m256i V;
+  static const int kLanes = 4;
+  static const int kBits = 27;
+  static const bool kSplitProducts = false;
+
+  static V Load(const uint64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void Store(uint64_t* p, V x) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);
+  }
+  static V Zero() { return _mm256_setzero_si256(); }
+  static V Add(V x, V y) { return _mm256_add_epi64(x, y); }
+  static V Shr(V x) { return _mm256_srli_epi64(x, kBits); }
+  static V Mask(V x) {
+    return _mm256_and_si256(x, _mm256_set1_epi64x((int64_t(1) << kBits) - 1));
+  }
+  static void MulAdd(V* lo, V a, V b) {
+    *lo = _mm256_add_epi64(*lo, _mm256_mul_epu32(a, b));
+  }
+  static V Quotient(V x, V ninv) {
+    return Mask(_mm256_mul_epu32(Mask(x), ninv));
+  }
+};
+
+void Avx2Mul(uint64_t* rp, const uint64_t* ap, const uint64_t* bp,
+             const uint64_t* np, const uint64_t* ninvp, int k, uint64_t* tp) {
+  BatchMontgomeryMul<Avx2>(rp, ap, bp, np, ninvp, k, tp);
+}
+
+}  // namespace
+
+#endif
+
+}  // namespace tf_big
+
+#if TF_BIG_BATCH_AVX2
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+namespace tf_big {
+
+const BatchKernels* Avx2BatchKernels() {
+#if TF_BIG_BATCH_AVX2
+  // With four lanes only exponentiation gains, by about 1.1x to 1.4x from 768
+  // bits against GMP on a CPU with mulx and adx.
+  static const BatchKernels kernels = {"avx2", Avx2::kLanes, Avx2::kBits,
+                                       kNeverFaster, 768, Avx2Mul};
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &kernels;
+  }
+#endif
+  return nullptr;
+}
+
+}  // namespace tf_big
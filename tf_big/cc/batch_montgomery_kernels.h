@@ -0,0 +1,186 @@
+#ifndef TF_BIG_CC_BATCH_MONTGOMERY_KERNELS_H_
+#define TF_BIG_CC_BATCH_MONTGOMERY_KERNELS_H_
+
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+
+namespace tf_big {
+
+// Almost-Montgomery multiplication for one instruction set, on a batch of
+// `lanes` values held vertically: every operand is k limbs of `limb_bits`
+// bits, and limb j of the value in lane l is at index j * lanes + l.
+//
+// `mul` sets rp = a b 2^(-limb_bits k) mod N, as normalized limbs in [0, 2N),
+// for a, b < 2N where 2^(limb_bits k) >= 4N. `np` and `ninvp` hold N and
+// -N^-1 mod 2^limb_bits in every lane, `tp` is k * lanes words of scratch,
+// and rp may alias the operands.
+struct BatchKernels {
+  const char* name;
+  int lanes;
+  int limb_bits;
+  // Smallest moduli, in bits, for which batched multiplications and
+  // exponentiations beat GMP, or kNeverFaster.
+  int min_mul_bits;
+  int min_pow_bits;
+  void (*mul)(uint64_t* rp, const uint64_t* ap, const uint64_t* bp,
+              const uint64_t* np, const uint64_t* ninvp, int k, uint64_t* tp);
+};
+
+const int kNeverFaster = INT_MAX;
+
+// Kernels for each instruction set, or nullptr when they are not compiled in
+// or not supported by this CPU. The scalar ones are a portable reference.
+const BatchKernels* ScalarBatchKernels();
+const BatchKernels* Avx2BatchKernels();
+const BatchKernels* Avx512IfmaBatchKernels();
+
+// Operand-scanning almost-Montgomery multiplication over the lanes of `Isa`,
+// which provides a vector type V of 64-bit lanes and these operations on it:
+//
+//   Load, Store, Zero, Add  the obvious
+//   Shr, Mask               x >> kBits and x mod 2^kBits
+//   MulAdd                  if kSplitProducts, MulAdd(lo, hi, a, b) adds the
+//                           low and high kBits of a b into the accumulators
+//                           of the current column (lo) and the next one (hi);
+//                           otherwise MulAdd(lo, a, b) adds all of it to lo
+//   Quotient(x, ninv)       (x mod 2^kBits) ninv mod 2^kBits
+//
+// Limbs are only normalized at the end, so Isa must leave enough headroom in
+// 64 bits for a column to accumulate 2k products.
+namespace batch_montgomery_internal {
+
+template <typename Isa>
+inline void MulAdd(typename Isa::V* lo, typename Isa::V* hi,
+                   typename Isa::V a, typename Isa::V b, std::true_type) {
+  Isa::MulAdd(lo, hi, a, b);
+}
+
+template <typename Isa>
+inline void MulAdd(typename Isa::V* lo, typename Isa::V*, typename Isa::V a,
+                   typename Isa::V b, std::false_type) {
+  Isa::MulAdd(lo, a, b);
+}
+
+// Adds a b to lo, or split between lo and hi, as Isa does.
+template <typename Isa>
+inline void MulAdd(typename Isa::V* lo, typename Isa::V* hi,
+                   typename Isa::V a, typename Isa::V b) {
+  MulAdd<Isa>(lo, hi, a, b,
+              std::integral_constant<bool, Isa::kSplitProducts>());
+}
+
+// Adds a b_i + m N to the accumulators t, for the quotient limb m that
+// clears column 0, and shifts them down by one limb.
+template <typename Isa>
+inline void AddRow(uint64_t* tp, const uint64_t* ap, typename Isa::V b,
+                   const uint64_t* np, typename Isa::V ninv, int k) {
+  typedef typename Isa::V V;
+  const int lanes = Isa::kLanes;
+
+  V x = Isa::Load(tp);
+  V hi = Isa::Zero();
+  MulAdd<Isa>(&x, &hi, Isa::Load(ap), b);
+  V m = Isa::Quotient(x, ninv);
+  MulAdd<Isa>(&x, &hi, m, Isa::Load(np));
+  hi = Isa::Add(hi, Isa::Shr(x));
+
+  for (int j = 1; j < k; j++) {
+    V y = Isa::Add(Isa::Load(tp + j * lanes), hi);
+    hi = Isa::Zero();
+    MulAdd<Isa>(&y, &hi, Isa::Load(ap + j * lanes), b);
+    MulAdd<Isa>(&y, &hi, m, Isa::Load(np + j * lanes));
+    Isa::Store(tp + (j - 1) * lanes, y);
+  }
+  Isa::Store(tp + (k - 1) * lanes, hi);
+}
+
+// Adds two rows at once, for b_i (b0) and b_i+1 (b1), and shifts the
+// accumulators down by two limbs. Every accumulator is then loaded and stored
+// once per four products instead of two. Requires k >= 2.
+template <typename Isa>
+inline void AddRows(uint64_t* tp, const uint64_t* ap, typename Isa::V b0,
+                    typename Isa::V b1, const uint64_t* np,
+                    typename Isa::V ninv, int k) {
+  typedef typename Isa::V V;
+  const int lanes = Isa::kLanes;
+
+  // Column 0 determines the first quotient limb, and column 1 with that row
+  // added the second.
+  V a_prev = Isa::Load(ap);
+  V n_prev = Isa::Load(np);
+  V x = Isa::Load(tp);
+  V hi = Isa::Zero();
+  MulAdd<Isa>(&x, &hi, a_prev, b0);
+  V m0 = Isa::Quotient(x, ninv);
+  MulAdd<Isa>(&x, &hi, m0, n_prev);
+
+  V a = Isa::Load(ap + lanes);
+  V n = Isa::Load(np + lanes);
+  V y = Isa::Add(Isa::Add(Isa::Load(tp + lanes), hi), Isa::Shr(x));
+  hi = Isa::Zero();
+  MulAdd<Isa>(&y, &hi, a, b0);
+  MulAdd<Isa>(&y, &hi, m0, n);
+  MulAdd<Isa>(&y, &hi, a_prev, b1);
+  V m1 = Isa::Quotient(y, ninv);
+  MulAdd<Isa>(&y, &hi, m1, n_prev);
+  hi = Isa::Add(hi, Isa::Shr(y));
+
+  for (int j = 2; j < k; j++) {
+    a_prev = a;
+    n_prev = n;
+    a = Isa::Load(ap + j * lanes);
+    n = Isa::Load(np + j * lanes);
+    y = Isa::Add(Isa::Load(tp + j * lanes), hi);
+    hi = Isa::Zero();
+    MulAdd<Isa>(&y, &hi, a, b0);
+    MulAdd<Isa>(&y, &hi, m0, n);
+    MulAdd<Isa>(&y, &hi, a_prev, b1);
+    MulAdd<Isa>(&y, &hi, m1, n_prev);
+    Isa::Store(tp + (j - 2) * lanes, y);
+  }
+
+  // Column k only gets the second row.
+  y = hi;
+  hi = Isa::Zero();
+  MulAdd<Isa>(&y, &hi, a, b1);
+  MulAdd<Isa>(&y, &hi, m1, n);
+  Isa::Store(tp + (k - 2) * lanes, y);
+  Isa::Store(tp + (k - 1) * lanes, hi);
+}
+
+}  // namespace batch_montgomery_internal
+
+template <typename Isa>
+void BatchMontgomeryMul(uint64_t* rp, const uint64_t* ap, const uint64_t* bp,
+                        const uint64_t* np, const uint64_t* ninvp, int k,
+                        uint64_t* tp) {
+  using namespace batch_montgomery_internal;
+  typedef typename Isa::V V;
+  const int lanes = Isa::kLanes;
+
+  for (int j = 0; j < k; j++) {
+    Isa::Store(tp + j * lanes, Isa::Zero());
+  }
+
+  V ninv = Isa::Load(ninvp);
+  int i = 0;
+  for (; i + 1 < k; i += 2) {
+    AddRows<Isa>(tp, ap, Isa::Load(bp + i * lanes),
+                 Isa::Load(bp + (i + 1) * lanes), np, ninv, k);
+  }
+  if (i < k) {
+    AddRow<Isa>(tp, ap, Isa::Load(bp + i * lanes), np, ninv, k);
+  }
+
+  V carry = Isa::Zero();
+  for (int j = 0; j < k; j++) {
+    V y = Isa::Add(Isa::Load(tp + j * lanes), carry);
+    Isa::Store(rp + j * lanes, Isa::Mask(y));
+    carry = Isa::Shr(y);
+  }
+}
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_BATCH_MONTGOMERY_KERNELS_H_
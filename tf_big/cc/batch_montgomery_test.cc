@@ -0,0 +1,171 @@
+#include "tf_big/cc/batch_montgomery.h"
+
+#include <gmpxx.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace tf_big {
+namespace {
+
+// The kernels for every instruction set this CPU supports, not only the one
+// that Get would pick, so that the scalar and AVX2 kernels are also run on
+// hosts with AVX-512 IFMA.
+std::vector<const BatchKernels*> AvailableKernels() {
+  std::vector<const BatchKernels*> available;
+  for (const BatchKernels* kernels :
+       {ScalarBatchKernels(), Avx2BatchKernels(), Avx512IfmaBatchKernels()}) {
+    if (kernels != nullptr) {
+      available.push_back(kernels);
+    }
+  }
+  return available;
+}
+
+class BatchMontgomeryTest
+    : public ::testing::TestWithParam<const BatchKernels*> {
+ protected:
+  BatchMontgomeryTest() : random_(gmp_randinit_default) {}
+
+  // Odd moduli of the given size: a random one and 2^bits - 1.
+  std::vector<mpz_class> Moduli(int bits) {
+    if (bits == 2) {
+      return {3};
+    }
+    mpz_class n = random_.get_z_bits(bits) | 1;
+    mpz_setbit(n.get_mpz_t(), bits - 1);
+    return {n, (mpz_class(1) << bits) - 1};
+  }
+
+  // Inputs of any sign and size, including ones that need reducing.
+  mpz_class Input(const mpz_class& modulus, int i) {
+    size_t wide = mpz_sizeinbase(modulus.get_mpz_t(), 2) + 70;
+    switch (i % 4) {
+      case 0:
+        return random_.get_z_range(modulus);
+      case 1:
+        return modulus - 1;
+      case 2:
+        return -mpz_class(random_.get_z_bits(wide));
+      default:
+        return random_.get_z_bits(wide);
+    }
+  }
+
+  gmp_randclass random_;
+  BatchMontgomery::Workspace ws_;
+};
+
+const int kBits[] = {2, 3, 27, 52, 53, 64, 65, 100, 255, 512, 1024, 2048};
+
+TEST_P(BatchMontgomeryTest, MulMatchesGmp) {
+  for (int bits : kBits) {
+    for (const mpz_class& modulus : Moduli(bits)) {
+      SCOPED_TRACE(modulus.get_str(16));
+      BatchMontgomery engine(modulus.get_mpz_t(), *GetParam());
+      for (int count = 1; count <= engine.lanes(); count++) {
+        std::vector<mpz_class> x(count), y(count), r(count);
+        mpz_ptr rp[BatchMontgomery::kMaxLanes];
+        mpz_srcptr xp[BatchMontgomery::kMaxLanes];
+        mpz_srcptr yp[BatchMontgomery::kMaxLanes];
+        for (int l = 0; l < count; l++) {
+          x[l] = Input(modulus, l);
+          y[l] = Input(modulus, l + count);
+          rp[l] = r[l].get_mpz_t();
+          xp[l] = x[l].get_mpz_t();
+          yp[l] = y[l].get_mpz_t();
+        }
+        engine.Mul(rp, xp, yp, count, &ws_);
+        for (int l = 0; l < count; l++) {
+          mpz_class expected = x[l] * y[l] % modulus;
+          if (expected < 0) {
+            expected += modulus;
+          }
+          EXPECT_EQ(r[l], expected) << "lane " << l << " of " << count;
+        }
+
+        // Results written over the first operands.
+        std::vector<mpz_class> expected = r;
+        for (int l = 0; l < count; l++) {
+          rp[l] = x[l].get_mpz_t();
+        }
+        engine.Mul(rp, xp, yp, count, &ws_);
+        EXPECT_EQ(x, expected) << count << " lanes, aliased";
+      }
+    }
+  }
+}
+
+TEST_P(BatchMontgomeryTest, PowMatchesGmp) {
+  for (int bits : kBits) {
+    for (const mpz_class& modulus : Moduli(bits)) {
+      SCOPED_TRACE(modulus.get_str(16));
+      BatchMontgomery engine(modulus.get_mpz_t(), *GetParam());
+      for (int count = 1; count <= engine.lanes(); count++) {
+        std::vector<mpz_class> b(count), e(count), r(count), expected(count);
+        mpz_ptr rp[BatchMontgomery::kMaxLanes];
+        mpz_srcptr bp[BatchMontgomery::kMaxLanes];
+        mpz_srcptr ep[BatchMontgomery::kMaxLanes];
+        for (int l = 0; l < count; l++) {
+          b[l] = Input(modulus, l);
+          // Exponents of different lengths, including zero and one, so that
+          // lanes run out of digits at different windows.
+          e[l] = l == 1 || l == 2 ? mpz_class(l - 1)
+                                  : random_.get_z_bits(37 * l + count + 60);
+          mpz_powm(expected[l].get_mpz_t(), b[l].get_mpz_t(),
+                   e[l].get_mpz_t(), modulus.get_mpz_t());
+          rp[l] = r[l].get_mpz_t();
+          bp[l] = b[l].get_mpz_t();
+          ep[l] = e[l].get_mpz_t();
+        }
+        engine.Pow(rp, bp, ep, count, &ws_);
+        EXPECT_EQ(r, expected) << count << " lanes";
+
+        // Results written over the bases.
+        for (int l = 0; l < count; l++) {
+          rp[l] = b[l].get_mpz_t();
+        }
+        engine.Pow(rp, bp, ep, count, &ws_);
+        EXPECT_EQ(b, expected) << count << " lanes, aliased";
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Kernels, BatchMontgomeryTest, ::testing::ValuesIn(AvailableKernels()),
+    [](const ::testing::TestParamInfo<const BatchKernels*>& info) {
+      return std::string(info.param->name);
+    });
+
+// The handling of TF_BIG_BATCH_ISA values, which Get reads once per process.
+TEST(BatchMontgomerySelectTest, SelectKernels) {
+  std::vector<const BatchKernels*> available = AvailableKernels();
+  ASSERT_FALSE(available.empty());
+  const BatchKernels* best = available.back();
+
+  bool forced = true;
+  EXPECT_EQ(BatchMontgomery::SelectKernels(nullptr, &forced), best);
+  EXPECT_FALSE(forced);
+  forced = true;
+  EXPECT_EQ(BatchMontgomery::SelectKernels("", &forced), best);
+  EXPECT_FALSE(forced);
+
+  EXPECT_EQ(BatchMontgomery::SelectKernels("none", &forced), nullptr);
+  EXPECT_TRUE(forced);
+  for (const BatchKernels* kernels : available) {
+    forced = false;
+    EXPECT_EQ(BatchMontgomery::SelectKernels(kernels->name, &forced), kernels);
+    EXPECT_TRUE(forced);
+  }
+
+  // Unknown names fall back to the automatic choice.
+  forced = true;
+  EXPECT_EQ(BatchMontgomery::SelectKernels("avx9000", &forced), best);
+  EXPECT_FALSE(forced);
+}
+
+}  // namespace
+}  // namespace tf_big
@@ -0,0 +1,673 @@
+// Microbenchmarks for the big kernels.
+//
+// Kernels are instantiated directly on a CPU device, without a session or
+// graph, and timed over a sweep of operand bit widths and shapes. Results are
+// written to stdout as JSON, in the same layout as Google Benchmark's
+// `--benchmark_format=json`, so existing tooling can compare runs:
+//
+//   bazel run -c opt //tf_big:big_ops_benchmark -- \
+//       --bits=64,2048 --shapes=1x1,100x100 --filter=Pow > results.json
+//
+// Configurations whose estimated work exceeds `--max_cost` are skipped, which
+// keeps e.g. 4096-bit exponentiation of a 1000x1000 tensor out of the default
+// sweep.
+
+#include <gmp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/framework/variant_tensor_data.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tf_big/cc/big_tensor.h"
+
+namespace tf_big {
+namespace {
+
+using tensorflow::AllocatorAttributes;
+using tensorflow::DataType;
+using tensorflow::Device;
+using tensorflow::DeviceFactory;
+using tensorflow::FakeInput;
+using tensorflow::int32;
+using tensorflow::int64;
+using tensorflow::NodeDef;
+using tensorflow::NodeDefBuilder;
+using tensorflow::OpKernel;
+using tensorflow::OpKernelContext;
+using tensorflow::SessionOptions;
+using tensorflow::Status;
+using tensorflow::string;
+using tensorflow::Tensor;
+using tensorflow::TensorShape;
+using tensorflow::TensorValue;
+using tensorflow::Variant;
+using tensorflow::VariantTensorData;
+using tensorflow::errors::InvalidArgument;
+
+struct Config {
+  int bits;
+  int64 rows;
+  int64 cols;
+
+  int64 size() const { return rows * cols; }
+  double limbs() const { return (bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS; }
+};
+
+// A single kernel instance together with what it takes to call Compute.
+class KernelRunner {
+ public:
+  static Status Create(Device* device, const NodeDef& def,
+                       std::shared_ptr<KernelRunner>* runner) {
+    Status status;
+    auto kernel = tensorflow::CreateOpKernel(
+        tensorflow::DEVICE_CPU, device,
+        device->GetAllocator(AllocatorAttributes()), def,
+        TF_GRAPH_DEF_VERSION, &status);
+    TF_RETURN_IF_ERROR(status);
+    runner->reset(new KernelRunner(device, std::move(kernel)));
+    return Status::OK();
+  }
+
+  Status Run(const std::vector<Tensor>& inputs, std::vector<Tensor>* outputs) {
+    tensorflow::gtl::InlinedVector<TensorValue, 4> values;
+    for (const Tensor& input : inputs) {
+      values.push_back(TensorValue(const_cast<Tensor*>(&input)));
+    }
+    std::vector<AllocatorAttributes> output_attrs(kernel_->num_outputs());
+    std::function<void(std::function<void()>)> runner =
+        [](std::function<void()> fn) { fn(); };
+
+    OpKernelContext::Params params;
+    params.device = device_;
+    params.op_kernel = kernel_.get();
+    params.inputs = &values;
+    params.output_attr_array = output_attrs.data();
+    params.resource_manager = device_->resource_manager();
+    params.runner = &runner;
+
+    OpKernelContext ctx(&params, kernel_->num_outputs());
+    kernel_->Compute(&ctx);
+    TF_RETURN_IF_ERROR(ctx.status());
+
+    outputs->clear();
+    for (int i = 0; i < kernel_->num_outputs(); i++) {
+      outputs->push_back(*ctx.mutable_output(i));
+    }
+    return Status::OK();
+  }
+
+ private:
+  KernelRunner(Device* device, std::unique_ptr<OpKernel> kernel)
+      : device_(device), kernel_(std::move(kernel)) {}
+
+  Device* device_;
+  std::unique_ptr<OpKernel> kernel_;
+};
+
+typedef std::function<Status()> Body;
+
+// Turns a kernel and its inputs into something to time.
+Status KernelBody(Device* device, NodeDefBuilder* builder,
+                  std::vector<Tensor> inputs, Body* body) {
+  NodeDef def;
+  TF_RETURN_IF_ERROR(builder->Finalize(&def));
+  std::shared_ptr<KernelRunner> runner;
+  TF_RETURN_IF_ERROR(KernelRunner::Create(device, def, &runner));
+  auto shared_inputs = std::make_shared<std::vector<Tensor>>(inputs);
+  *body = [runner, shared_inputs]() {
+    std::vector<Tensor> outputs;
+    return runner->Run(*shared_inputs, &outputs);
+  };
+  return Status::OK();
+}
+
+// Runs a kernel once, for preparing the inputs of another.
+Status RunOnce(Device* device, NodeDefBuilder* builder,
+               const std::vector<Tensor>& inputs,
+               std::vector<Tensor>* outputs) {
+  NodeDef def;
+  TF_RETURN_IF_ERROR(builder->Finalize(&def));
+  std::shared_ptr<KernelRunner> runner;
+  TF_RETURN_IF_ERROR(KernelRunner::Create(device, def, &runner));
+  return runner->Run(inputs, outputs);
+}
+
+class Operands {
+ public:
+  Operands() {
+    gmp_randinit_mt(state_);
+    gmp_randseed_ui(state_, 42);
+  }
+  ~Operands() { gmp_randclear(state_); }
+
+  Tensor Wrap(BigTensor big, int64 rows, int64 cols) {
+    Tensor t(tensorflow::DT_VARIANT, TensorShape{rows, cols});
+    t.flat<Variant>()(0) = std::move(big);
+    return t;
+  }
+
+  // Uniformly random values of up to `bits` bits.
+  BigTensor RandomBig(int64 rows, int64 cols, int bits) {
+    MatrixXm m(rows, cols);
+    for (Index i = 0; i < m.size(); i++) {
+      mpz_urandomb(m.data()[i].get_mpz_t(), state_, bits);
+    }
+    return BigTensor(std::move(m));
+  }
+
+  Tensor Random(const Config& c) {
+    return Wrap(RandomBig(c.rows, c.cols, c.bits), c.rows, c.cols);
+  }
+
+  Tensor Random(int64 rows, int64 cols, int bits) {
+    return Wrap(RandomBig(rows, cols, bits), rows, cols);
+  }
+
+  // An odd modulus of exactly `bits` bits.
+  Tensor OddModulus(int bits) {
+    mpz_class m;
+    mpz_urandomb(m.get_mpz_t(), state_, bits);
+    mpz_setbit(m.get_mpz_t(), bits - 1);
+    mpz_setbit(m.get_mpz_t(), 0);
+    return Wrap(BigTensor(m), 1, 1);
+  }
+
+  // A prime modulus of `bits` bits, so that every non-zero value is
+  // invertible. These are slow to find and hence cached.
+  Tensor PrimeModulus(int bits) {
+    auto it = primes_.find(bits);
+    if (it == primes_.end()) {
+      mpz_class p;
+      mpz_urandomb(p.get_mpz_t(), state_, bits - 1);
+      mpz_setbit(p.get_mpz_t(), bits - 1);
+      mpz_nextprime(p.get_mpz_t(), p.get_mpz_t());
+      it = primes_.insert({bits, Wrap(BigTensor(p), 1, 1)}).first;
+    }
+    return it->second;
+  }
+
+  Tensor Int32(int32 value) {
+    Tensor t(tensorflow::DT_INT32, TensorShape{});
+    t.scalar<int32>()() = value;
+    return t;
+  }
+
+ private:
+  gmp_randstate_t state_;
+  std::map<int, Tensor> primes_;
+};
+
+struct Benchmark {
+  string name;
+  // Rough work per run in limb operations, used to skip configurations that
+  // would take too long; negative if the configuration does not apply.
+  std::function<double(const Config&)> cost;
+  std::function<Status(Device*, Operands*, const Config&, Body*)> setup;
+};
+
+double Linear(const Config& c) { return c.size() * c.limbs(); }
+double Quadratic(const Config& c) { return c.size() * c.limbs() * c.limbs(); }
+double Exponentiation(const Config& c) { return Quadratic(c) * c.bits; }
+
+// Element-wise binary kernels on two random operands of the same shape.
+Benchmark Binary(const string& op,
+                 std::function<double(const Config&)> cost) {
+  return {op, cost, [op](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", op);
+            b.Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b, {o->Random(c), o->Random(c)}, body);
+          }};
+}
+
+Benchmark Pow(bool secure) {
+  return {secure ? "BigPow/secure" : "BigPow", Exponentiation,
+          [secure](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigPow");
+            b.Attr("secure", secure)
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(
+                d, &b, {o->Random(c), o->Random(c), o->OddModulus(c.bits)},
+                body);
+          }};
+}
+
+// Fused modular multiplication; odd moduli from 512 bits take the batched
+// path on CPUs with AVX-512 IFMA.
+Benchmark MulMod() {
+  return {"BigMulMod", Quadratic,
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigMulMod");
+            b.Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(
+                d, &b, {o->Random(c), o->Random(c), o->OddModulus(c.bits)},
+                body);
+          }};
+}
+
+Benchmark Mod() {
+  // Reduces double-width values, as after a multiplication.
+  return {"BigMod", Quadratic,
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigMod");
+            b.Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b,
+                              {o->Random(c.rows, c.cols, 2 * c.bits),
+                               o->OddModulus(c.bits)},
+                              body);
+          }};
+}
+
+Benchmark Inv(bool batched) {
+  return {batched ? "BigInv/batched" : "BigInv",
+          [](const Config& c) { return 8 * Quadratic(c); },
+          [batched](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigInv");
+            b.Attr("batched", batched)
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            // Values below the modulus, which are non-zero with overwhelming
+            // probability for all but the narrowest widths.
+            return KernelBody(d, &b,
+                              {o->Random(c.rows, c.cols, c.bits - 1),
+                               o->PrimeModulus(c.bits)},
+                              body);
+          }};
+}
+
+// Montgomery-domain kernels on operands below an odd modulus of `bits` bits;
+// moduli of up to 512 bits run on the fixed-width kernels.
+Benchmark Montgomery(const string& op,
+                     std::function<double(const Config&)> cost) {
+  return {op, cost, [op](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", op);
+            b.Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b,
+                              {o->Random(c.rows, c.cols, c.bits - 1),
+                               o->Random(c.rows, c.cols, c.bits - 1),
+                               o->OddModulus(c.bits)},
+                              body);
+          }};
+}
+
+Benchmark MatMul() {
+  // Multiplies the rows x cols operand by a square cols x cols one.
+  return {"BigMatMul",
+          [](const Config& c) { return Quadratic(c) * c.cols; },
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigMatMul");
+            b.Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b,
+                              {o->Random(c), o->Random(c.cols, c.cols, c.bits)},
+                              body);
+          }};
+}
+
+// Moves every element to a new position, as the other layout kernels do.
+Benchmark Transpose() {
+  return {"BigTranspose", Linear,
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigTranspose");
+            b.Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b, {o->Random(c)}, body);
+          }};
+}
+
+Benchmark RandomUniform() {
+  return {"BigRandomUniform", Linear,
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigRandomUniform");
+            b.Input(FakeInput(tensorflow::DT_INT32))
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            Tensor shape(tensorflow::DT_INT32, TensorShape{2});
+            shape.flat<int32>()(0) = c.rows;
+            shape.flat<int32>()(1) = c.cols;
+            return KernelBody(d, &b, {shape, o->OddModulus(c.bits)}, body);
+          }};
+}
+
+Benchmark RandomRsaModulus() {
+  // Generates one modulus per element; each prime search tests on the order
+  // of `bits` candidates with a cubic-cost primality test.
+  return {"BigRandomRsaModulus",
+          [](const Config& c) {
+            return c.bits < 128 ? -1 : Exponentiation(c) * c.bits / 8;
+          },
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigRandomRsaModulus");
+            b.Attr("batch_size", static_cast<int>(c.size()))
+                .Input(FakeInput(tensorflow::DT_INT32));
+            return KernelBody(d, &b, {o->Int32(c.bits)}, body);
+          }};
+}
+
+Benchmark ExportString(const string& format) {
+  return {"BigExport/" + format, Quadratic,
+          [format](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigExport");
+            b.Attr("dtype", tensorflow::DT_STRING)
+                .Attr("string_format", format.c_str())
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b, {o->Random(c)}, body);
+          }};
+}
+
+Benchmark ImportString(const string& format) {
+  return {"BigImport/" + format, Quadratic,
+          [format](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder e("export", "BigExport");
+            e.Attr("dtype", tensorflow::DT_STRING)
+                .Attr("string_format", format.c_str())
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            std::vector<Tensor> strings;
+            TF_RETURN_IF_ERROR(RunOnce(d, &e, {o->Random(c)}, &strings));
+
+            NodeDefBuilder b("bench", "BigImport");
+            b.Attr("string_format", format.c_str())
+                .Input(FakeInput(tensorflow::DT_STRING));
+            return KernelBody(d, &b, strings, body);
+          }};
+}
+
+// Native integer conversion, only meaningful for 64-bit operands.
+Benchmark ExportInt64() {
+  return {"BigExport/int64",
+          [](const Config& c) { return c.bits == 64 ? Linear(c) : -1; },
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigExport");
+            b.Attr("dtype", tensorflow::DT_INT64)
+                .Input(FakeInput(tensorflow::DT_VARIANT));
+            return KernelBody(d, &b, {o->Random(c.rows, c.cols, 63)}, body);
+          }};
+}
+
+Benchmark ImportInt64() {
+  return {"BigImport/int64",
+          [](const Config& c) { return c.bits == 64 ? Linear(c) : -1; },
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            Tensor x(tensorflow::DT_INT64, TensorShape{c.rows, c.cols});
+            auto flat = x.flat<int64>();
+            for (int64 i = 0; i < flat.size(); i++) {
+              flat(i) = i * 0x9E3779B97F4A7C15ULL;
+            }
+            NodeDefBuilder b("bench", "BigImport");
+            b.Input(FakeInput(tensorflow::DT_INT64));
+            return KernelBody(d, &b, {x}, body);
+          }};
+}
+
+Benchmark ExportLimbs(DataType dtype, const string& layout) {
+  return {"BigExportLimbs/" + tensorflow::DataTypeString(dtype) + "/" + layout,
+          Linear,
+          [dtype, layout](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder b("bench", "BigExportLimbs");
+            b.Attr("dtype", dtype)
+                .Attr("layout", layout.c_str())
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_INT32));
+            return KernelBody(d, &b, {o->Random(c), o->Int32(c.bits)}, body);
+          }};
+}
+
+Benchmark ImportLimbs(DataType dtype, const string& layout) {
+  return {"BigImportLimbs/" + tensorflow::DataTypeString(dtype) + "/" + layout,
+          Linear,
+          [dtype, layout](Device* d, Operands* o, const Config& c, Body* body) {
+            NodeDefBuilder e("export", "BigExportLimbs");
+            e.Attr("dtype", dtype)
+                .Attr("layout", layout.c_str())
+                .Input(FakeInput(tensorflow::DT_VARIANT))
+                .Input(FakeInput(tensorflow::DT_INT32));
+            std::vector<Tensor> limbs;
+            TF_RETURN_IF_ERROR(
+                RunOnce(d, &e, {o->Random(c), o->Int32(c.bits)}, &limbs));
+
+            NodeDefBuilder b("bench", "BigImportLimbs");
+            b.Attr("layout", layout.c_str()).Input(FakeInput(dtype));
+            return KernelBody(d, &b, limbs, body);
+          }};
+}
+
+// Variant serialization, as done when a big tensor crosses a device or is
+// checkpointed; timed without a kernel around it.
+Benchmark Encode() {
+  return {"Variant/Encode", Linear,
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            auto big = std::make_shared<BigTensor>(
+                o->RandomBig(c.rows, c.cols, c.bits));
+            *body = [big]() {
+              VariantTensorData data;
+              big->Encode(&data);
+              return Status::OK();
+            };
+            return Status::OK();
+          }};
+}
+
+Benchmark Decode() {
+  return {"Variant/Decode", Linear,
+          [](Device* d, Operands* o, const Config& c, Body* body) {
+            auto data = std::make_shared<VariantTensorData>();
+            o->RandomBig(c.rows, c.cols, c.bits).Encode(data.get());
+            *body = [data]() {
+              BigTensor big;
+              if (!big.Decode(*data)) {
+                return InvalidArgument("failed to decode big tensor");
+              }
+              return Status::OK();
+            };
+            return Status::OK();
+          }};
+}
+
+std::vector<Benchmark> AllBenchmarks() {
+  return {
+      Binary("BigAdd", Linear),
+      Binary("BigSub", Linear),
+      Binary("BigMul", Quadratic),
+      Mod(),
+      MulMod(),
+      Inv(false),
+      Inv(true),
+      Pow(false),
+      Pow(true),
+      Montgomery("BigMontgomeryMul", Quadratic),
+      Montgomery("BigMontgomeryPow", Exponentiation),
+      MatMul(),
+      Transpose(),
+      RandomUniform(),
+      RandomRsaModulus(),
+      ImportString("decimal"),
+      ExportString("decimal"),
+      ImportString("hex"),
+      ExportString("hex"),
+      ImportInt64(),
+      ExportInt64(),
+      ImportLimbs(tensorflow::DT_UINT8, "header"),
+      ExportLimbs(tensorflow::DT_UINT8, "header"),
+      ImportLimbs(tensorflow::DT_UINT64, "fixed"),
+      ExportLimbs(tensorflow::DT_UINT64, "fixed"),
+      Encode(),
+      Decode(),
+  };
+}
+
+// Times `body`, doubling the number of iterations until a batch runs for at
+// least `min_time` seconds. Returns the seconds per iteration of that batch.
+Status Measure(const Body& body, double min_time, int64* iterations,
+               double* seconds) {
+  TF_RETURN_IF_ERROR(body());  // warm-up
+
+  typedef std::chrono::steady_clock Clock;
+  for (int64 n = 1;; n *= 2) {
+    auto start = Clock::now();
+    for (int64 i = 0; i < n; i++) {
+      TF_RETURN_IF_ERROR(body());
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    if (elapsed.count() >= min_time || n >= (int64(1) << 30)) {
+      *iterations = n;
+      *seconds = elapsed.count() / n;
+      return Status::OK();
+    }
+  }
+}
+
+Status ParseConfigs(const string& bits_flag, const string& shapes_flag,
+                    std::vector<Config>* configs) {
+  std::vector<int32> bits;
+  for (const string& b : tensorflow::str_util::Split(bits_flag, ',')) {
+    int32 value;
+    if (!tensorflow::strings::safe_strto32(b, &value) || value < 2) {
+      return InvalidArgument("bad bit width '", b, "'");
+    }
+    bits.push_back(value);
+  }
+  for (const string& s : tensorflow::str_util::Split(shapes_flag, ',')) {
+    std::vector<string> dims = tensorflow::str_util::Split(s, 'x');
+    int64 rows, cols;
+    if (dims.size() != 2 ||
+        !tensorflow::strings::safe_strto64(dims[0], &rows) ||
+        !tensorflow::strings::safe_strto64(dims[1], &cols) || rows < 1 ||
+        cols < 1) {
+      return InvalidArgument("bad shape '", s, "', expected ROWSxCOLS");
+    }
+    for (int32 b : bits) {
+      configs->push_back({b, rows, cols});
+    }
+  }
+  return Status::OK();
+}
+
+int Main(int argc, char** argv) {
+  string bits_flag = "64,256,1024,2048,4096";
+  string shapes_flag = "1x1,10x10,100x100,1000x1000";
+  string filter;
+  float min_time = 0.5;
+  float max_cost = 1e10;
+  int32 threads = 0;
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("bits", &bits_flag, "comma-separated operand widths"),
+      tensorflow::Flag("shapes", &shapes_flag,
+                       "comma-separated shapes given as ROWSxCOLS"),
+      tensorflow::Flag("filter", &filter,
+                       "only run benchmarks whose name contains this"),
+      tensorflow::Flag("min_time", &min_time,
+                       "minimum seconds to time each configuration for"),
+      tensorflow::Flag("max_cost", &max_cost,
+                       "skip configurations estimated to need more limb "
+                       "operations than this per run"),
+      tensorflow::Flag("threads", &threads,
+                       "intra-op threads, or 0 for one per core"),
+  };
+  string usage = tensorflow::Flags::Usage(argv[0], flag_list);
+  if (!tensorflow::Flags::Parse(&argc, argv, flag_list) || argc != 1) {
+    std::fprintf(stderr, "%s", usage.c_str());
+    return 2;
+  }
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+
+  std::vector<Config> configs;
+  Status status = ParseConfigs(bits_flag, shapes_flag, &configs);
+  if (!status.ok()) {
+    std::fprintf(stderr, "%s\n%s", status.ToString().c_str(), usage.c_str());
+    return 2;
+  }
+
+  SessionOptions options;
+  options.config.set_intra_op_parallelism_threads(threads);
+  std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+      "CPU", options, "/job:localhost/replica:0/task:0");
+  if (device == nullptr) {
+    std::fprintf(stderr, "could not create a CPU device\n");
+    return 1;
+  }
+
+  std::printf("{\n  \"context\": {\n");
+  std::printf("    \"tensorflow_version\": \"%s\",\n", TF_VERSION_STRING);
+  std::printf("    \"gmp_version\": \"%s\",\n", gmp_version);
+  std::printf("    \"num_threads\": %d,\n",
+              device->tensorflow_cpu_worker_threads()->num_threads);
+  std::printf("    \"min_time\": %g,\n    \"max_cost\": %g\n  },\n", min_time,
+              max_cost);
+  std::printf("  \"benchmarks\": [");
+
+  Operands operands;
+  bool first = true;
+  int failures = 0;
+  for (const Benchmark& benchmark : AllBenchmarks()) {
+    if (benchmark.name.find(filter) == string::npos) {
+      continue;
+    }
+    for (const Config& c : configs) {
+      double cost = benchmark.cost(c);
+      std::ostringstream name;
+      name << benchmark.name << "/" << c.bits << "/" << c.rows << "x" << c.cols;
+      if (cost < 0 || cost > max_cost) {
+        continue;
+      }
+      std::fprintf(stderr, "%s\n", name.str().c_str());
+
+      Body body;
+      int64 iterations = 0;
+      double seconds = 0;
+      status = benchmark.setup(device.get(), &operands, c, &body);
+      if (status.ok()) {
+        status = Measure(body, min_time, &iterations, &seconds);
+      }
+      if (!status.ok()) {
+        std::fprintf(stderr, "  failed: %s\n", status.ToString().c_str());
+        failures++;
+        continue;
+      }
+
+      std::printf("%s\n    {\"name\": \"%s\", \"op\": \"%s\", \"bits\": %d, "
+                  "\"rows\": %lld, \"cols\": %lld, \"iterations\": %lld, "
+                  "\"real_time\": %.1f, \"time_unit\": \"ns\", "
+                  "\"items_per_second\": %.6g}",
+                  first ? "" : ",", name.str().c_str(), benchmark.name.c_str(),
+                  c.bits, static_cast<long long>(c.rows),
+                  static_cast<long long>(c.cols),
+                  static_cast<long long>(iterations), seconds * 1e9,
+                  c.size() / seconds);
+      std::fflush(stdout);
+      first = false;
+    }
+  }
+  std::printf("\n  ]\n}\n");
+  return failures == 0 ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace tf_big
+
+int main(int argc, char** argv) { return tf_big::Main(argc, argv); }
@@ -2,62 +2,244 @@
 
 #include <gmp.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
+#include <utility>
+
+#include "tensorflow/core/util/overflow.h"
 
 namespace tf_big {
-BigTensor::BigTensor(const MatrixXm& mat) { value = mat; }
 
-BigTensor::BigTensor(const BigTensor& other) { value = other.value; }
+namespace {
+
+// Variant encoding: an int64 header tensor with the fields below, an int32
+// tensor with the signed limb count of every element, and a uint64 tensor with
+// the limbs of all elements packed back to back, least significant first.
+const int64 kEncodingVersion = 1;
+enum EncodingHeader {
+  kHeaderVersion,
+  kHeaderStorage,
+  kHeaderRows,
+  kHeaderCols,
+  kHeaderWidth,
+  kHeaderSize
+};
+
+static_assert(sizeof(mp_limb_t) == sizeof(uint64),
+              "limbs are encoded as uint64");
+
+}  // namespace
+
+BigTensor::BigTensor(MatrixXm mat)
+    : value_(SharedStorage<MatrixXm>::Make(std::move(mat))) {}
+
+BigTensor::BigTensor(LimbMatrix mat)
+    : limbs_(SharedStorage<LimbMatrix>::Make(std::move(mat))),
+      storage_(kLimbs) {}
 
-BigTensor::BigTensor(mpz_class m) {
-  value = MatrixXm(1, 1);
-  value(0, 0) = m;
+BigTensor::BigTensor(mpz_class m)
+    : value_(SharedStorage<MatrixXm>::Make(1, 1)) {
+  (*value_)(0, 0) = std::move(m);
 }
 
-void BigTensor::Encode(VariantTensorData* data) const {
-  auto rows = value.rows();
-  auto cols = value.cols();
+const MatrixXm& BigTensor::EmptyMatrix() {
+  static const MatrixXm* empty = new MatrixXm();
+  return *empty;
+}
 
-  auto shape = TensorShape{rows, cols};
-  Tensor t(DT_STRING, shape);
+const LimbMatrix& BigTensor::EmptyLimbs() {
+  static const LimbMatrix* empty = new LimbMatrix();
+  return *empty;
+}
 
-  auto mat = t.matrix<tstring>();
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      size_t count_p;
+MatrixXm* BigTensor::mutable_value() {
+  if (!value_) {
+    value_ = SharedStorage<MatrixXm>::Make();
+  } else if (!value_.unique()) {
+    value_ = SharedStorage<MatrixXm>::Make(*value_);
+  }
+  return value_.get();
+}
 
-      char* p = reinterpret_cast<char*>(mpz_export(
-          NULL, &count_p, 1, sizeof(int32), 0, 0, value(i, j).get_mpz_t()));
+LimbMatrix* BigTensor::mutable_limbs() {
+  if (!limbs_) {
+    limbs_ = SharedStorage<LimbMatrix>::Make();
+  } else if (!limbs_.unique()) {
+    limbs_ = SharedStorage<LimbMatrix>::Make(*limbs_);
+  }
+  return limbs_.get();
+}
+
+Status BigTensor::ParseStorage(const string& name, Storage* storage) {
+  if (name == "mpz") {
+    *storage = kMpz;
+  } else if (name == "limbs") {
+    *storage = kLimbs;
+  } else {
+    return errors::InvalidArgument("Unknown storage '", name, "'");
+  }
+  return Status::OK();
+}
 
-      int total_size = count_p * sizeof(int32);
+void BigTensor::ConvertTo(Storage storage) {
+  if (storage == storage_) {
+    return;
+  }
 
-      mat(i, j) = tstring(p, total_size);
+  // Converting never writes to the current storage, so it is not copied
+  // even if shared.
+  if (storage == kLimbs) {
+    const MatrixXm& value = this->value();
+    mp_size_t width = 0;
+    for (Index i = 0; i < value.size(); i++) {
+      width = std::max<mp_size_t>(width, mpz_size(value.data()[i].get_mpz_t()));
+    }
+    auto limbs =
+        SharedStorage<LimbMatrix>::Make(value.rows(), value.cols(), width);
+    for (Index i = 0; i < value.size(); i++) {
+      limbs->set(i, value.data()[i].get_mpz_t());
+    }
+    limbs_ = std::move(limbs);
+    value_.reset();
+  } else {
+    const LimbMatrix& limbs = this->limbs();
+    auto value = SharedStorage<MatrixXm>::Make(limbs.rows(), limbs.cols());
+    mpz_t view;
+    for (Index i = 0; i < value->size(); i++) {
+      mpz_set(value->data()[i].get_mpz_t(), limbs.view(i, view));
     }
+    value_ = std::move(value);
+    limbs_.reset();
   }
+  storage_ = storage;
+}
 
-  *data->add_tensors() = t;
+const MatrixXm& BigTensor::AsMatrix(MatrixXm* scratch) const {
+  if (storage_ == kMpz) {
+    return value();
+  }
+
+  const LimbMatrix& limbs = this->limbs();
+  *scratch = MatrixXm(limbs.rows(), limbs.cols());
+  mpz_t view;
+  for (Index i = 0; i < scratch->size(); i++) {
+    mpz_set(scratch->data()[i].get_mpz_t(), limbs.view(i, view));
+  }
+  return *scratch;
+}
+
+void BigTensor::Encode(VariantTensorData* data) const {
+  auto size = this->size();
+
+  Tensor header(DT_INT64, TensorShape{kHeaderSize});
+  auto header_flat = header.flat<int64>();
+  header_flat(kHeaderVersion) = kEncodingVersion;
+  header_flat(kHeaderStorage) = storage_;
+  header_flat(kHeaderRows) = rows();
+  header_flat(kHeaderCols) = cols();
+  // Padding is not kept, so that Decode can check the width against the
+  // element sizes.
+  header_flat(kHeaderWidth) = storage_ == kLimbs ? limbs().max_size() : 0;
+
+  Tensor sizes(DT_INT32, TensorShape{size});
+  auto sizes_flat = sizes.flat<int32>();
+  mpz_t view;
+  int64 num_limbs = 0;
+  for (Index i = 0; i < size; i++) {
+    auto x = element(i, view);
+    auto n = static_cast<int32>(mpz_size(x));
+    sizes_flat(i) = mpz_sgn(x) < 0 ? -n : n;
+    num_limbs += mpz_size(x);
+  }
+
+  Tensor packed(DT_UINT64, TensorShape{num_limbs});
+  auto dst = reinterpret_cast<mp_limb_t*>(packed.flat<uint64>().data());
+  for (Index i = 0; i < size; i++) {
+    auto x = element(i, view);
+    dst = std::copy(mpz_limbs_read(x), mpz_limbs_read(x) + mpz_size(x), dst);
+  }
+
+  *data->add_tensors() = header;
+  *data->add_tensors() = sizes;
+  *data->add_tensors() = packed;
 
   data->set_type_name(TypeName());
 }
 
 bool BigTensor::Decode(const VariantTensorData& data) {
-  if (!TensorShapeUtils::IsMatrix(data.tensors()[0].shape())) {
+  if (data.tensors_size() != 3) {
+    return false;
+  }
+  const Tensor& header = data.tensors(0);
+  const Tensor& sizes = data.tensors(1);
+  const Tensor& packed = data.tensors(2);
+  if (header.dtype() != DT_INT64 || header.NumElements() != kHeaderSize ||
+      sizes.dtype() != DT_INT32 || packed.dtype() != DT_UINT64) {
     return false;
   }
 
-  auto mat = data.tensors()[0].matrix<tstring>();
-
-  auto rows = data.tensors()[0].dim_size(0);
-  auto cols = data.tensors()[0].dim_size(1);
+  auto header_flat = header.flat<int64>();
+  auto storage = header_flat(kHeaderStorage);
+  auto rows = header_flat(kHeaderRows);
+  auto cols = header_flat(kHeaderCols);
+  auto width = header_flat(kHeaderWidth);
+  if (header_flat(kHeaderVersion) != kEncodingVersion ||
+      (storage != kMpz && storage != kLimbs) || rows < 0 || cols < 0 ||
+      width < 0) {
+    return false;
+  }
+  // The header is untrusted, so bound the sizes before they are used for
+  // allocation; MultiplyWithoutOverflow returns -1 on overflow.
+  int64 size = MultiplyWithoutOverflow(rows, cols);
+  if (size < 0 || sizes.NumElements() != size ||
+      (storage == kLimbs && MultiplyWithoutOverflow(size, width) < 0)) {
+    return false;
+  }
 
-  value = MatrixXm(rows, cols);
+  // Check the element sizes against the packed limbs before touching them,
+  // and the width against the element sizes before allocating it; Encode
+  // writes the largest element size.
+  auto sizes_flat = sizes.flat<int32>();
+  int64 num_limbs = 0;
+  int64 max_size = 0;
+  for (Index i = 0; i < sizes_flat.size(); i++) {
+    int64 n = std::labs(sizes_flat(i));
+    max_size = std::max(max_size, n);
+    num_limbs += n;
+  }
+  if (num_limbs != packed.NumElements() ||
+      width != (storage == kLimbs ? max_size : 0)) {
+    return false;
+  }
 
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      mpz_import(value(i, j).get_mpz_t(), 1, 1, sizeof(int32), 0, 0,
-                 mat(i, j).c_str());
+  auto src = reinterpret_cast<const mp_limb_t*>(packed.flat<uint64>().data());
+  if (storage == kLimbs) {
+    auto limbs = SharedStorage<LimbMatrix>::Make(rows, cols, width);
+    for (Index i = 0; i < limbs->size(); i++) {
+      auto n = std::labs(sizes_flat(i));
+      std::copy(src, src + n, limbs->limbs(i));
+      limbs->set_signed_size(i, sizes_flat(i));
+      src += n;
+    }
+    limbs_ = std::move(limbs);
+    value_.reset();
+  } else {
+    auto value = SharedStorage<MatrixXm>::Make(rows, cols);
+    for (Index i = 0; i < value->size(); i++) {
+      auto n = std::labs(sizes_flat(i));
+      if (n == 0) {
+        continue;
+      }
+      auto x = value->data()[i].get_mpz_t();
+      std::copy(src, src + n, mpz_limbs_write(x, n));
+      mpz_limbs_finish(x, sizes_flat(i));
+      src += n;
     }
+    value_ = std::move(value);
+    limbs_.reset();
   }
+  storage_ = static_cast<Storage>(storage);
 
   return true;
 }
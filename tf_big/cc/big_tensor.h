@@ -1,12 +1,11 @@
 #ifndef TF_BIG_CC_BIG_TENSOR_H_
 #define TF_BIG_CC_BIG_TENSOR_H_
 
-#include <fcntl.h>
 #include <gmp.h>
 #include <gmpxx.h>
-#include <unistd.h>
 
 #include <string>
+#include <utility>
 
 #include "Eigen/Core"
 #include "Eigen/Dense"
@@ -17,6 +16,8 @@
 #include "tensorflow/core/framework/variant_encode_decode.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tf_big/cc/limb_matrix.h"
 
 using Eigen::Dynamic;
 using Eigen::Index;
@@ -50,27 +51,6 @@ typedef Matrix<mpz_class, Dynamic, Dynamic> MatrixXm;
 
 namespace tf_big {
 
-namespace gmp_utils {
-inline void reseed(unsigned long& seed) {
-  int file;
-  /* re-seed random number generator */
-  if ((file = open("/dev/urandom", O_RDONLY)) == -1) {
-    (void)fprintf(stderr, "Error opening /dev/urandom\n");
-  } else {
-    if (read(file, &seed, sizeof seed) == -1) {
-      (void)fprintf(stderr, "Error reading from /dev/urandom\n");
-      (void)close(file);
-    }
-  }
-}
-inline void init_randstate(gmp_randstate_t& state) {
-  gmp_randinit_mt(state);
-  unsigned long seed;
-  reseed(seed);
-  gmp_randseed_ui(state, seed);
-}
-}  // namespace gmp_utils
-
 inline void encode_length(uint8_t* buffer, unsigned int len) {
   buffer[0] = len & 0xFF;
   buffer[1] = (len >> 8) & 0xFF;
@@ -82,11 +62,84 @@ inline unsigned int decode_length(const uint8_t* buffer) {
          0x1000000 * buffer[3];
 }
 
+// Reference-counted pointer to a `T`, used for the storage of a BigTensor.
+//
+// This stands in for std::shared_ptr because copy-on-write needs to know
+// that a reference is the only one left. shared_ptr::use_count() is a
+// relaxed load, so seeing 1 does not order this thread after writes made
+// through references that other threads have since dropped. unique() uses
+// core::RefCounted::RefCountIsOne(), which is an acquire load.
+template <typename T>
+class SharedStorage {
+ public:
+  SharedStorage() {}
+  SharedStorage(const SharedStorage& other) : holder_(other.holder_) {
+    if (holder_) {
+      holder_->Ref();
+    }
+  }
+  SharedStorage(SharedStorage&& other) : holder_(other.holder_) {
+    other.holder_ = nullptr;
+  }
+  SharedStorage& operator=(SharedStorage other) {
+    std::swap(holder_, other.holder_);
+    return *this;
+  }
+  ~SharedStorage() { reset(); }
+
+  // Returns a new `T` constructed from `args`, with a single reference.
+  template <typename... Args>
+  static SharedStorage Make(Args&&... args) {
+    SharedStorage result;
+    result.holder_ = new Holder(std::forward<Args>(args)...);
+    return result;
+  }
+
+  void reset() {
+    if (holder_) {
+      holder_->Unref();
+      holder_ = nullptr;
+    }
+  }
+
+  // Whether this is the only reference to the `T`, or holds none.
+  bool unique() const { return !holder_ || holder_->RefCountIsOne(); }
+
+  T* get() const { return holder_ ? &holder_->value : nullptr; }
+  T& operator*() const { return holder_->value; }
+  T* operator->() const { return &holder_->value; }
+  explicit operator bool() const { return holder_ != nullptr; }
+
+ private:
+  struct Holder : public core::RefCounted {
+    template <typename... Args>
+    explicit Holder(Args&&... args) : value(std::forward<Args>(args)...) {}
+    T value;
+  };
+
+  Holder* holder_ = nullptr;
+};
+
+// A matrix of big integers, held as the element 0 of a variant tensor.
+//
+// The elements live in reference-counted storage that is shared between
+// copies, so copying a BigTensor -- as TF does when it copies or forwards
+// variant tensors -- is cheap. Storage is copied on write: the `mutable_*`
+// accessors first give this tensor a private copy if the storage is shared.
 struct BigTensor {
+  // How the elements are held in memory: either as one mpz_class per element
+  // in `value()`, or packed into a single fixed-width limb buffer in
+  // `limbs()`.
+  enum Storage { kMpz, kLimbs };
+
   BigTensor() {}
-  BigTensor(const BigTensor& other);
+  BigTensor(const BigTensor& other) = default;
+  BigTensor(BigTensor&& other) = default;
+  BigTensor& operator=(const BigTensor& other) = default;
+  BigTensor& operator=(BigTensor&& other) = default;
   explicit BigTensor(mpz_class m);
-  explicit BigTensor(const MatrixXm& mat);
+  explicit BigTensor(MatrixXm mat);
+  explicit BigTensor(LimbMatrix mat);
 
   static const char kTypeName[];
   string TypeName() const { return kTypeName; }
@@ -97,65 +150,49 @@ struct BigTensor {
 
   string DebugString() const { return "BigTensor"; }
 
-  template <typename T>
-  void FromTensor(const Tensor& t) {
-    auto rows = t.dim_size(0);
-    auto cols = t.dim_size(1);
+  // Parses a storage attribute value, "mpz" or "limbs".
+  static Status ParseStorage(const string& name, Storage* storage);
 
-    value = MatrixXm(rows, cols);
+  Storage storage() const { return storage_; }
 
-    auto mat = t.matrix<T>();
-    for (int i = 0; i < rows; i++) {
-      for (int j = 0; j < cols; j++) {
-        value(i, j) = mpz_class(mat(i, j));
-      }
-    }
-  }
+  // Switches to the given storage, converting the elements if needed.
+  void ConvertTo(Storage storage);
 
-  template <typename T>
-  void ToTensor(Tensor* t) const {
-    auto rows = value.rows();
-    auto cols = value.cols();
-
-    if ((rows == 1) && (cols == 1)) {
-      auto mat = t->scalar<T>();
-      mat(0) = value(0, 0).get_str();
-    } else {
-      auto mat = t->matrix<T>();
-      for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-          mat(i, j) = value(i, j).get_str();
-        }
-      }
-    }
+  // Only one of these is in use at a time, as given by `storage()`; the other
+  // is empty.
+  const MatrixXm& value() const { return value_ ? *value_ : EmptyMatrix(); }
+  const LimbMatrix& limbs() const { return limbs_ ? *limbs_ : EmptyLimbs(); }
+
+  // Writable access to the elements, copying them first if the storage is
+  // shared with another tensor. Not safe to call concurrently on the same
+  // tensor, so kernels should call these before sharding.
+  MatrixXm* mutable_value();
+  LimbMatrix* mutable_limbs();
+
+  // Whether the storage is referenced by this tensor only, so that writing
+  // to it does not copy.
+  bool unique() const {
+    return storage_ == kLimbs ? limbs_.unique() : value_.unique();
   }
-  template <typename T>
-  void LimbsFromTensor(const Tensor& t) {
-    int rows = t.dim_size(0);
-    int cols = t.dim_size(1);
-    size_t num_real_limbs =
-        t.dim_size(2) * sizeof(T) - 4;  // get rid of header length
-
-    value = MatrixXm(rows, cols);
-
-    auto input_tensor = t.flat<T>();
-    const uint8_t* buffer =
-        reinterpret_cast<const uint8_t*>(input_tensor.data());
-
-    size_t pointer = 0;
-    for (int i = 0; i < rows; i++) {
-      for (int j = 0; j < cols; j++) {
-        unsigned int length = decode_length(buffer + pointer);
-        pointer += 4;
-        mpz_import(value(i, j).get_mpz_t(), length, 1, sizeof(uint8_t), 0, 0,
-                   buffer + pointer);
-        pointer += num_real_limbs;
-      }
+
+  // Returns element `i` (in column-major order) as a read-only mpz without
+  // copying; `view` is scratch space used for limb storage and must outlive
+  // the result.
+  mpz_srcptr element(Index i, mpz_ptr view) const {
+    if (storage_ == kLimbs) {
+      return limbs_->view(i, view);
     }
+    return value_->data()[i].get_mpz_t();
   }
 
+  // Returns the elements as a MatrixXm, unpacking into `scratch` if they are
+  // held in limb storage.
+  const MatrixXm& AsMatrix(MatrixXm* scratch) const;
+
   BigTensor& operator+=(const BigTensor& rhs) {
-    this->value += rhs.value;
+    MatrixXm scratch;
+    ConvertTo(kMpz);
+    *mutable_value() += rhs.AsMatrix(&scratch);
     return *this;
   }
 
@@ -166,7 +203,9 @@ struct BigTensor {
   }
 
   BigTensor& operator-=(const BigTensor& rhs) {
-    this->value -= rhs.value;
+    MatrixXm scratch;
+    ConvertTo(kMpz);
+    *mutable_value() -= rhs.AsMatrix(&scratch);
     return *this;
   }
 
@@ -177,7 +216,9 @@ struct BigTensor {
   }
 
   BigTensor& operator*=(const BigTensor& rhs) {
-    this->value *= rhs.value;
+    MatrixXm scratch;
+    ConvertTo(kMpz);
+    *mutable_value() *= rhs.AsMatrix(&scratch);
     return *this;
   }
 
@@ -187,65 +228,43 @@ struct BigTensor {
     return lhs;
   }
 
-  mpz_class operator()(Index i, Index j) const { return value(i, j); }
+  mpz_class operator()(Index i, Index j) const {
+    mpz_t view;
+    return mpz_class(element(j * rows() + i, view));
+  }
 
   BigTensor cwiseProduct(const BigTensor& rhs) const {
-    return BigTensor(this->value.cwiseProduct(rhs.value));
+    MatrixXm scratch0, scratch1;
+    return BigTensor(
+        AsMatrix(&scratch0).cwiseProduct(rhs.AsMatrix(&scratch1)));
   }
 
   BigTensor cwiseQuotient(const BigTensor& rhs) const {
-    return BigTensor(this->value.cwiseQuotient(rhs.value));
+    MatrixXm scratch0, scratch1;
+    return BigTensor(
+        AsMatrix(&scratch0).cwiseQuotient(rhs.AsMatrix(&scratch1)));
   }
 
-  Index rows() const { return value.rows(); }
-
-  Index cols() const { return value.cols(); }
-
-  TensorShape shape() const { return TensorShape{value.rows(), value.cols()}; }
-
-  MatrixXm value;
-};
-
-template <>
-inline void BigTensor::ToTensor<int32>(Tensor* t) const {
-  auto rows = value.rows();
-  auto cols = value.cols();
-
-  auto mat = t->matrix<int32>();
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      mat(i, j) = value(i, j).get_si();
-    }
+  Index rows() const {
+    return storage_ == kLimbs ? limbs().rows() : value().rows();
   }
-}
 
-template <>
-inline void BigTensor::ToTensor<uint8>(Tensor* t) const {
-  auto rows = value.rows();
-  auto cols = value.cols();
-
-  auto mat = t->matrix<uint8>();
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      mat(i, j) = (uint8)value(i, j).get_si();
-    }
+  Index cols() const {
+    return storage_ == kLimbs ? limbs().cols() : value().cols();
   }
-}
 
-template <>
-inline void BigTensor::FromTensor<tstring>(const Tensor& t) {
-  auto rows = t.dim_size(0);
-  auto cols = t.dim_size(1);
+  Index size() const { return rows() * cols(); }
 
-  value = MatrixXm(rows, cols);
+  TensorShape shape() const { return TensorShape{rows(), cols()}; }
 
-  auto mat = t.matrix<tstring>();
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      value(i, j) = mpz_class(mat(i, j), 10);
-    }
-  }
-}
+ private:
+  static const MatrixXm& EmptyMatrix();
+  static const LimbMatrix& EmptyLimbs();
+
+  SharedStorage<MatrixXm> value_;
+  SharedStorage<LimbMatrix> limbs_;
+  Storage storage_ = kMpz;
+};
 
 }  // namespace tf_big
 
@@ -0,0 +1,68 @@
+#include "tf_big/cc/counters.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace tf_big {
+
+namespace {
+
+std::mutex registry_mutex;
+
+std::map<std::string, std::unique_ptr<OpCounters>>& Registry() {
+  static auto registry = new std::map<std::string, std::unique_ptr<OpCounters>>;
+  return *registry;
+}
+
+thread_local ScopedOpActivity* current_activity = nullptr;
+
+}  // namespace
+
+OpCounters* Counters::Get(const std::string& op) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto& entry = Registry()[op];
+  if (entry == nullptr) {
+    entry.reset(new OpCounters);
+  }
+  return entry.get();
+}
+
+std::vector<Counters::Snapshot> Counters::Read() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::vector<Snapshot> res;
+  for (const auto& entry : Registry()) {
+    const OpCounters& c = *entry.second;
+    res.push_back({entry.first, c.calls.load(std::memory_order_relaxed),
+                   c.elements.load(std::memory_order_relaxed),
+                   c.limb_ops.load(std::memory_order_relaxed),
+                   c.wall_nanos.load(std::memory_order_relaxed)});
+  }
+  return res;
+}
+
+ScopedOpActivity::ScopedOpActivity(OpCounters* counters)
+    : counters_(counters),
+      start_(std::chrono::steady_clock::now()),
+      previous_(current_activity) {
+  current_activity = this;
+}
+
+ScopedOpActivity::~ScopedOpActivity() {
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start_);
+  counters_->calls.fetch_add(1, std::memory_order_relaxed);
+  counters_->wall_nanos.fetch_add(elapsed.count(), std::memory_order_relaxed);
+  current_activity = previous_;
+}
+
+void ScopedOpActivity::AddWork(int64_t elements, int64_t limb_ops) {
+  if (current_activity == nullptr) {
+    return;
+  }
+  OpCounters* counters = current_activity->counters_;
+  counters->elements.fetch_add(elements, std::memory_order_relaxed);
+  counters->limb_ops.fetch_add(limb_ops, std::memory_order_relaxed);
+}
+
+}  // namespace tf_big
@@ -0,0 +1,65 @@
+#ifndef TF_BIG_CC_COUNTERS_H_
+#define TF_BIG_CC_COUNTERS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tf_big {
+
+// Cumulative statistics for all kernels of one op type in this process.
+//
+// `limb_ops` is the work estimated by the kernels' cost model, the same figure
+// used to shard them, so it is comparable across ops and operand sizes rather
+// than an exact count.
+struct OpCounters {
+  std::atomic<int64_t> calls{0};
+  std::atomic<int64_t> elements{0};
+  std::atomic<int64_t> limb_ops{0};
+  std::atomic<int64_t> wall_nanos{0};
+};
+
+// Process-wide registry of OpCounters, keyed by op type. Entries are created on
+// first use and never removed, so pointers to them stay valid for the life of
+// the process and updating them only takes relaxed atomic adds.
+class Counters {
+ public:
+  struct Snapshot {
+    std::string op;
+    int64_t calls;
+    int64_t elements;
+    int64_t limb_ops;
+    int64_t wall_nanos;
+  };
+
+  static OpCounters* Get(const std::string& op);
+
+  // Current values of all counters, sorted by op type.
+  static std::vector<Snapshot> Read();
+};
+
+// Attributes one kernel invocation to `counters`: the call itself, its wall
+// time, and any work reported through AddWork on the same thread while the
+// activity is alive.
+class ScopedOpActivity {
+ public:
+  explicit ScopedOpActivity(OpCounters* counters);
+  ~ScopedOpActivity();
+
+  ScopedOpActivity(const ScopedOpActivity&) = delete;
+  ScopedOpActivity& operator=(const ScopedOpActivity&) = delete;
+
+  // Adds to the innermost activity on this thread, if any.
+  static void AddWork(int64_t elements, int64_t limb_ops);
+
+ private:
+  OpCounters* counters_;
+  std::chrono::steady_clock::time_point start_;
+  ScopedOpActivity* previous_;
+};
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_COUNTERS_H_
@@ -0,0 +1,72 @@
+#include "tf_big/cc/fixed_base.h"
+
+#include <algorithm>
+
+namespace tf_big {
+
+FixedBaseTable::FixedBaseTable(mpz_srcptr base, mpz_srcptr modulus,
+                               int max_bits, int window)
+    : context_(MontgomeryContext::Get(modulus)),
+      max_bits_(max_bits),
+      window_(window),
+      num_positions_((max_bits + window - 1) / window) {
+  mpz_init_set(base_, base);
+
+  auto n = context_->size();
+  size_t digits = (size_t(1) << window_) - 1;
+  table_.resize(num_positions_ * digits * n);
+  base_mont_.resize(n);
+
+  std::vector<mp_limb_t> tp(2 * n);
+  mpz_t tmp;
+  mpz_init(tmp);
+  context_->ToMontgomery(base_mont_.data(), base_, tmp, tp.data());
+  mpz_clear(tmp);
+
+  // Row i starts from g^(2^(window * i)), obtained by squaring the previous
+  // row's start `window` times; the rest of the row are its multiples.
+  std::vector<mp_limb_t> start(base_mont_);
+  for (size_t i = 0; i < num_positions_; i++) {
+    mp_limb_t* row = table_.data() + i * digits * n;
+    std::copy(start.begin(), start.end(), row);
+    for (size_t d = 1; d < digits; d++) {
+      context_->Mul(row + d * n, row + (d - 1) * n, start.data(), tp.data());
+    }
+    for (int b = 0; b < window_; b++) {
+      context_->Sqr(start.data(), start.data(), tp.data());
+    }
+  }
+}
+
+FixedBaseTable::~FixedBaseTable() { mpz_clear(base_); }
+
+void FixedBaseTable::Pow(mp_limb_t* rp, mpz_srcptr e,
+                         std::vector<mp_limb_t>* scratch) const {
+  auto n = context_->size();
+
+  if (mpz_sizeinbase(e, 2) > static_cast<size_t>(max_bits_)) {
+    context_->Pow(rp, base_mont_.data(), e, scratch);
+    scratch->resize(std::max<size_t>(scratch->size(), 2 * n));
+    context_->FromMontgomery(rp, rp, scratch->data());
+    return;
+  }
+
+  scratch->resize(std::max<size_t>(scratch->size(), 3 * n));
+  mp_limb_t* acc = scratch->data();
+  mp_limb_t* tp = acc + n;
+
+  std::copy(context_->one(), context_->one() + n, acc);
+  for (size_t i = 0; i < num_positions_; i++) {
+    size_t digit = 0;
+    for (int b = window_ - 1; b >= 0; b--) {
+      digit = (digit << 1) | mpz_tstbit(e, i * window_ + b);
+    }
+    if (digit != 0) {
+      context_->Mul(acc, acc, entry(i, digit), tp);
+    }
+  }
+
+  context_->FromMontgomery(rp, acc, tp);
+}
+
+}  // namespace tf_big
@@ -0,0 +1,63 @@
+#ifndef TF_BIG_CC_FIXED_BASE_H_
+#define TF_BIG_CC_FIXED_BASE_H_
+
+#include <gmp.h>
+
+#include <memory>
+#include <vector>
+
+#include "tf_big/cc/montgomery.h"
+
+namespace tf_big {
+
+// Precomputed powers of a fixed base g modulo an odd modulus N, for computing
+// g^e with one Montgomery multiplication per `window` bits of the exponent and
+// no squarings.
+//
+// The exponent is split into digits d_i of `window` bits, and the table holds
+// g^(d * 2^(window * i)) for every digit value d and position i, so that
+// g^e is the product of one table entry per non-zero digit.
+class FixedBaseTable {
+ public:
+  // `modulus` must be odd and greater than one; exponents of up to
+  // `max_bits` bits are served from the table.
+  FixedBaseTable(mpz_srcptr base, mpz_srcptr modulus, int max_bits,
+                 int window);
+  ~FixedBaseTable();
+
+  FixedBaseTable(const FixedBaseTable&) = delete;
+  FixedBaseTable& operator=(const FixedBaseTable&) = delete;
+
+  mpz_srcptr base() const { return base_; }
+  mpz_srcptr modulus() const { return context_->modulus(); }
+  const MontgomeryContext& context() const { return *context_; }
+
+  // rp = g^e mod N as an n-limb vector for a non-negative exponent `e`.
+  // Exponents longer than the table fall back to a regular exponentiation.
+  // `scratch` is resized as needed and can be reused across calls.
+  void Pow(mp_limb_t* rp, mpz_srcptr e, std::vector<mp_limb_t>* scratch) const;
+
+  // Approximate memory held by the table, in bytes.
+  size_t MemoryUsed() const { return table_.size() * sizeof(mp_limb_t); }
+
+ private:
+  const mp_limb_t* entry(size_t position, size_t digit) const {
+    return table_.data() +
+           (position * ((size_t(1) << window_) - 1) + digit - 1) *
+               context_->size();
+  }
+
+  mpz_t base_;
+  std::shared_ptr<const MontgomeryContext> context_;
+  int max_bits_;
+  int window_;
+  size_t num_positions_;
+  // g in Montgomery form, for the fallback path
+  std::vector<mp_limb_t> base_mont_;
+  // Entries for digits 1 .. 2^window - 1 at every position, in Montgomery form
+  std::vector<mp_limb_t> table_;
+};
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_FIXED_BASE_H_
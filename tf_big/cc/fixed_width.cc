@@ -0,0 +1,283 @@
+#include "tf_big/cc/fixed_width.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace tf_big {
+
+#if defined(__SIZEOF_INT128__) && GMP_NUMB_BITS == 64 && GMP_NAIL_BITS == 0
+
+namespace {
+
+typedef unsigned __int128 Wide;
+
+// Largest specialized width. Past 512 bits the quadratic loops are long
+// enough that GMP's hand-written assembly (mulx/adx on x86-64) overtakes
+// straight-line C++, so wider moduli keep using the mpn functions.
+const int kMaxLimbs = 8;
+
+// Loops below have compile-time bounds of at most 2 kMaxLimbs, small enough
+// to unroll completely.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define TF_BIG_UNROLL _Pragma("GCC unroll 16")
+#else
+#define TF_BIG_UNROLL
+#endif
+
+// Whether a >= b, comparing from the most significant limb.
+template <int N>
+inline bool GreaterEqual(const mp_limb_t* ap, const mp_limb_t* bp) {
+  TF_BIG_UNROLL
+  for (int i = N - 1; i >= 0; i--) {
+    if (ap[i] != bp[i]) {
+      return ap[i] > bp[i];
+    }
+  }
+  return true;
+}
+
+// rp = a + b, returning the carry out.
+template <int N>
+inline mp_limb_t AddN(mp_limb_t* rp, const mp_limb_t* ap,
+                      const mp_limb_t* bp) {
+  mp_limb_t carry = 0;
+  TF_BIG_UNROLL
+  for (int i = 0; i < N; i++) {
+    Wide t = static_cast<Wide>(ap[i]) + bp[i] + carry;
+    rp[i] = static_cast<mp_limb_t>(t);
+    carry = static_cast<mp_limb_t>(t >> 64);
+  }
+  return carry;
+}
+
+// rp = a - b, returning the borrow out.
+template <int N>
+inline mp_limb_t SubN(mp_limb_t* rp, const mp_limb_t* ap,
+                      const mp_limb_t* bp) {
+  mp_limb_t borrow = 0;
+  TF_BIG_UNROLL
+  for (int i = 0; i < N; i++) {
+    Wide t = static_cast<Wide>(ap[i]) - bp[i] - borrow;
+    rp[i] = static_cast<mp_limb_t>(t);
+    borrow = static_cast<mp_limb_t>(t >> 64) & 1;
+  }
+  return borrow;
+}
+
+// Three-limb column accumulator for product scanning.
+struct Accumulator {
+  Wide low = 0;
+  mp_limb_t high = 0;
+
+  void Add(mp_limb_t a) {
+    low += a;
+    high += low < a;
+  }
+
+  void MulAdd(mp_limb_t a, mp_limb_t b) {
+    Wide p = static_cast<Wide>(a) * b;
+    low += p;
+    high += low < p;
+  }
+
+  // Adds twice the value of `other`, which must be below 2^191.
+  void AddTwice(const Accumulator& other) {
+    Wide twice = other.low << 1;
+    high += (other.high << 1) | static_cast<mp_limb_t>(other.low >> 127);
+    low += twice;
+    high += low < twice;
+  }
+
+  // Returns the low limb and shifts the accumulator down by one limb.
+  mp_limb_t Shift() {
+    mp_limb_t limb = static_cast<mp_limb_t>(low);
+    low = (low >> 64) | (static_cast<Wide>(high) << 64);
+    high = 0;
+    return limb;
+  }
+};
+
+// rp = t - np if t >= np, else t, for an N-limb t plus a top bit.
+template <int N>
+inline void FinalSubtract(mp_limb_t* rp, const mp_limb_t* t, mp_limb_t top,
+                          const mp_limb_t* np) {
+  if (top != 0 || GreaterEqual<N>(t, np)) {
+    SubN<N>(rp, t, np);
+  } else {
+    TF_BIG_UNROLL
+    for (int i = 0; i < N; i++) {
+      rp[i] = t[i];
+    }
+  }
+}
+
+// Mul and Redc interleave the product and the reduction one column at a
+// time (finely integrated product scanning): column i of the product and of
+// m N is summed into a three-limb accumulator, for the low columns the
+// quotient limb m_i is chosen to clear the low limb, and the accumulator is
+// shifted down. Unlike operand scanning this keeps a single carry chain in
+// registers and never writes partial products back to memory.
+template <int N>
+void Mul(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+         const mp_limb_t* np, mp_limb_t ninv) {
+  mp_limb_t m[N];
+  mp_limb_t t[N];
+  Accumulator acc;
+  TF_BIG_UNROLL
+  for (int i = 0; i < N; i++) {
+    TF_BIG_UNROLL
+    for (int j = 0; j < i; j++) {
+      acc.MulAdd(ap[j], bp[i - j]);
+      acc.MulAdd(m[j], np[i - j]);
+    }
+    acc.MulAdd(ap[i], bp[0]);
+    m[i] = static_cast<mp_limb_t>(acc.low) * ninv;
+    acc.MulAdd(m[i], np[0]);
+    acc.Shift();
+  }
+  TF_BIG_UNROLL
+  for (int i = N; i < 2 * N - 1; i++) {
+    TF_BIG_UNROLL
+    for (int j = i - N + 1; j < N; j++) {
+      acc.MulAdd(ap[j], bp[i - j]);
+      acc.MulAdd(m[j], np[i - j]);
+    }
+    t[i - N] = acc.Shift();
+  }
+  t[N - 1] = acc.Shift();
+  FinalSubtract<N>(rp, t, acc.Shift(), np);
+}
+
+template <int N>
+void Redc(mp_limb_t* rp, mp_limb_t* tp, const mp_limb_t* np,
+          mp_limb_t ninv) {
+  mp_limb_t m[N];
+  Accumulator acc;
+  TF_BIG_UNROLL
+  for (int i = 0; i < N; i++) {
+    acc.Add(tp[i]);
+    TF_BIG_UNROLL
+    for (int j = 0; j < i; j++) {
+      acc.MulAdd(m[j], np[i - j]);
+    }
+    m[i] = static_cast<mp_limb_t>(acc.low) * ninv;
+    acc.MulAdd(m[i], np[0]);
+    acc.Shift();
+  }
+  // The low half of tp is consumed, so the result can be built there.
+  TF_BIG_UNROLL
+  for (int i = N; i < 2 * N; i++) {
+    acc.Add(tp[i]);
+    TF_BIG_UNROLL
+    for (int j = i - N + 1; j < N; j++) {
+      acc.MulAdd(m[j], np[i - j]);
+    }
+    tp[i - N] = acc.Shift();
+  }
+  FinalSubtract<N>(rp, tp, acc.Shift(), np);
+}
+
+// Sqr follows Mul, but sums each cross product a_j a_{i-j} (j < i - j) of a
+// column once and doubles it before adding the diagonal a_{i/2}^2, which
+// takes N (N + 1) / 2 multiplications for the square instead of N^2.
+template <int N>
+void Sqr(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* np,
+         mp_limb_t ninv) {
+  mp_limb_t m[N];
+  mp_limb_t t[N];
+  Accumulator acc;
+  TF_BIG_UNROLL
+  for (int i = 0; i < N; i++) {
+    Accumulator cross;
+    TF_BIG_UNROLL
+    for (int j = 0; 2 * j < i; j++) {
+      cross.MulAdd(ap[j], ap[i - j]);
+    }
+    acc.AddTwice(cross);
+    if (i % 2 == 0) {
+      acc.MulAdd(ap[i / 2], ap[i / 2]);
+    }
+    TF_BIG_UNROLL
+    for (int j = 0; j < i; j++) {
+      acc.MulAdd(m[j], np[i - j]);
+    }
+    m[i] = static_cast<mp_limb_t>(acc.low) * ninv;
+    acc.MulAdd(m[i], np[0]);
+    acc.Shift();
+  }
+  TF_BIG_UNROLL
+  for (int i = N; i < 2 * N - 1; i++) {
+    Accumulator cross;
+    TF_BIG_UNROLL
+    for (int j = i - N + 1; 2 * j < i; j++) {
+      cross.MulAdd(ap[j], ap[i - j]);
+    }
+    acc.AddTwice(cross);
+    if (i % 2 == 0) {
+      acc.MulAdd(ap[i / 2], ap[i / 2]);
+    }
+    TF_BIG_UNROLL
+    for (int j = i - N + 1; j < N; j++) {
+      acc.MulAdd(m[j], np[i - j]);
+    }
+    t[i - N] = acc.Shift();
+  }
+  t[N - 1] = acc.Shift();
+  FinalSubtract<N>(rp, t, acc.Shift(), np);
+}
+
+template <int N>
+void Add(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+         const mp_limb_t* np) {
+  mp_limb_t carry = AddN<N>(rp, ap, bp);
+  if (carry != 0 || GreaterEqual<N>(rp, np)) {
+    SubN<N>(rp, rp, np);
+  }
+}
+
+template <int N>
+void Sub(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+         const mp_limb_t* np) {
+  if (SubN<N>(rp, ap, bp) != 0) {
+    AddN<N>(rp, rp, np);
+  }
+}
+
+template <int N>
+FixedWidthKernels Kernels() {
+  static_assert(N >= 1 && N <= kMaxLimbs, "unsupported width");
+  return {N, Mul<N>, Sqr<N>, Redc<N>, Add<N>, Sub<N>};
+}
+
+const FixedWidthKernels kKernels[] = {
+    Kernels<2>(), Kernels<3>(), Kernels<4>(), Kernels<5>(),
+    Kernels<6>(), Kernels<7>(), Kernels<8>(),
+};
+
+}  // namespace
+
+const FixedWidthKernels* GetFixedWidthKernels(mp_size_t limbs) {
+  static const bool disabled = [] {
+    const char* env = std::getenv("TF_BIG_FIXED_WIDTH");
+    return env != nullptr && std::strcmp(env, "0") == 0;
+  }();
+  if (disabled) {
+    return nullptr;
+  }
+  for (const FixedWidthKernels& kernels : kKernels) {
+    if (kernels.limbs == limbs) {
+      return &kernels;
+    }
+  }
+  return nullptr;
+}
+
+#else
+
+const FixedWidthKernels* GetFixedWidthKernels(mp_size_t limbs) {
+  return nullptr;
+}
+
+#endif
+
+}  // namespace tf_big
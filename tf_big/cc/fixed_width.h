@@ -0,0 +1,45 @@
+#ifndef TF_BIG_CC_FIXED_WIDTH_H_
+#define TF_BIG_CC_FIXED_WIDTH_H_
+
+#include <gmp.h>
+
+namespace tf_big {
+
+// Montgomery arithmetic specialized at compile time for moduli of a fixed
+// number of limbs N, currently 2 to 8 limbs (128 to 512 bits).
+//
+// With N known every loop is unrolled completely and products are computed
+// inline with 128-bit integer arithmetic, avoiding GMP's per-call overhead
+// and size handling, which dominate at these sizes. All operands and results
+// are exactly N limbs reduced below the modulus `np`, and results may alias
+// operands. `ninv` is -np^-1 mod 2^64.
+struct FixedWidthKernels {
+  mp_size_t limbs;
+
+  // rp = a b R^-1 mod N (CIOS Montgomery multiplication).
+  void (*mul)(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+              const mp_limb_t* np, mp_limb_t ninv);
+
+  // rp = a^2 R^-1 mod N, squaring before reducing.
+  void (*sqr)(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* np,
+              mp_limb_t ninv);
+
+  // rp = t R^-1 mod N for a 2N-limb t < N R; `tp` is destroyed.
+  void (*redc)(mp_limb_t* rp, mp_limb_t* tp, const mp_limb_t* np,
+               mp_limb_t ninv);
+
+  // rp = a + b mod N and rp = a - b mod N.
+  void (*add)(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+              const mp_limb_t* np);
+  void (*sub)(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+              const mp_limb_t* np);
+};
+
+// Returns the kernels for moduli of `limbs` limbs, or nullptr if there is no
+// specialization for that size or platform, or if disabled by setting
+// TF_BIG_FIXED_WIDTH=0; callers then fall back to GMP's mpn functions.
+const FixedWidthKernels* GetFixedWidthKernels(mp_size_t limbs);
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_FIXED_WIDTH_H_
@@ -0,0 +1,246 @@
+#include "tf_big/cc/gmp_allocator.h"
+
+#include <gmp.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+
+namespace tf_big {
+
+namespace {
+
+const size_t kMinClassBytes = 16;
+const int kNumClasses = 9;
+const size_t kMaxPooledBytes = kMinClassBytes << (kNumClasses - 1);
+const size_t kMaxCachedBytesPerClass = 256 * 1024;
+
+int SizeClass(size_t n) {
+  int k = 0;
+  while ((kMinClassBytes << k) < n) {
+    k++;
+  }
+  return k;
+}
+
+size_t ClassBytes(int k) { return kMinClassBytes << k; }
+
+// Pooled blocks are always allocated at their full class size, so that a
+// block can be cached by whichever thread frees it.
+size_t AllocationBytes(size_t n) {
+  return n <= kMaxPooledBytes ? ClassBytes(SizeClass(n)) : n;
+}
+
+// Counters written only by their owning thread but read by others; the
+// load-add-store avoids the cost of a locked read-modify-write.
+struct Stat {
+  std::atomic<int64_t> value{0};
+
+  void Add(int64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta,
+                std::memory_order_relaxed);
+  }
+  int64_t Get() const { return value.load(std::memory_order_relaxed); }
+};
+
+struct Stats {
+  Stat allocations;
+  Stat pool_hits;
+  Stat bytes_allocated;
+  Stat bytes_freed;
+  Stat bytes_cached;
+};
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct ThreadCache {
+  FreeBlock* blocks[kNumClasses] = {};
+  size_t cached_bytes[kNumClasses] = {};
+  Stats stats;
+};
+
+bool pool_enabled = false;
+
+// Live thread caches, plus the totals of threads that have exited and of
+// allocations made while a thread's cache was being torn down.
+std::mutex registry_mutex;
+
+std::set<ThreadCache*>& Registry() {
+  static auto registry = new std::set<ThreadCache*>;
+  return *registry;
+}
+
+std::atomic<int64_t> retired_allocations{0};
+std::atomic<int64_t> retired_pool_hits{0};
+std::atomic<int64_t> retired_bytes_allocated{0};
+std::atomic<int64_t> retired_bytes_freed{0};
+
+// A plain pointer rather than a thread_local object with a destructor, so
+// that it stays usable when GMP frees memory during thread or process
+// teardown after the cache itself is gone.
+thread_local ThreadCache* thread_cache = nullptr;
+thread_local bool thread_cache_released = false;
+
+void ReleaseCache(ThreadCache* cache) {
+  for (int k = 0; k < kNumClasses; k++) {
+    while (cache->blocks[k] != nullptr) {
+      FreeBlock* block = cache->blocks[k];
+      cache->blocks[k] = block->next;
+      std::free(block);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  Registry().erase(cache);
+  retired_allocations += cache->stats.allocations.Get();
+  retired_pool_hits += cache->stats.pool_hits.Get();
+  retired_bytes_allocated += cache->stats.bytes_allocated.Get();
+  retired_bytes_freed += cache->stats.bytes_freed.Get();
+  delete cache;
+}
+
+struct CacheReleaser {
+  ~CacheReleaser() {
+    ReleaseCache(thread_cache);
+    thread_cache = nullptr;
+    thread_cache_released = true;
+  }
+};
+
+ThreadCache* GetCache() {
+  if (thread_cache == nullptr && !thread_cache_released) {
+    static thread_local CacheReleaser releaser;
+    thread_cache = new ThreadCache;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    Registry().insert(thread_cache);
+  }
+  return thread_cache;
+}
+
+void* Malloc(size_t n) {
+  void* p = std::malloc(n);
+  if (p == nullptr) {
+    // GMP has no way to report allocation failure.
+    std::fprintf(stderr, "GNU MP: Cannot allocate memory (size=%zu)\n", n);
+    std::abort();
+  }
+  return p;
+}
+
+void* Allocate(size_t n) {
+  ThreadCache* cache = GetCache();
+  if (cache == nullptr) {
+    retired_allocations++;
+    retired_bytes_allocated += n;
+    return Malloc(AllocationBytes(n));
+  }
+
+  cache->stats.allocations.Add(1);
+  cache->stats.bytes_allocated.Add(n);
+  if (n <= kMaxPooledBytes) {
+    int k = SizeClass(n);
+    FreeBlock* block = cache->blocks[k];
+    if (block != nullptr) {
+      cache->blocks[k] = block->next;
+      cache->cached_bytes[k] -= ClassBytes(k);
+      cache->stats.bytes_cached.Add(-static_cast<int64_t>(ClassBytes(k)));
+      cache->stats.pool_hits.Add(1);
+      return block;
+    }
+  }
+  return Malloc(AllocationBytes(n));
+}
+
+void Free(void* p, size_t n) {
+  ThreadCache* cache = GetCache();
+  if (cache == nullptr) {
+    retired_bytes_freed += n;
+    std::free(p);
+    return;
+  }
+
+  cache->stats.bytes_freed.Add(n);
+  if (n <= kMaxPooledBytes) {
+    int k = SizeClass(n);
+    if (cache->cached_bytes[k] + ClassBytes(k) <= kMaxCachedBytesPerClass) {
+      FreeBlock* block = static_cast<FreeBlock*>(p);
+      block->next = cache->blocks[k];
+      cache->blocks[k] = block;
+      cache->cached_bytes[k] += ClassBytes(k);
+      cache->stats.bytes_cached.Add(ClassBytes(k));
+      return;
+    }
+  }
+  std::free(p);
+}
+
+void* Reallocate(void* p, size_t old_size, size_t new_size) {
+  if (AllocationBytes(old_size) == AllocationBytes(new_size) ||
+      (old_size > kMaxPooledBytes && new_size > kMaxPooledBytes)) {
+    ThreadCache* cache = GetCache();
+    if (cache != nullptr) {
+      cache->stats.bytes_allocated.Add(new_size);
+      cache->stats.bytes_freed.Add(old_size);
+    } else {
+      retired_bytes_allocated += new_size;
+      retired_bytes_freed += old_size;
+    }
+    if (AllocationBytes(old_size) == AllocationBytes(new_size)) {
+      return p;
+    }
+    void* q = std::realloc(p, new_size);
+    if (q == nullptr) {
+      std::fprintf(stderr, "GNU MP: Cannot reallocate memory (size=%zu)\n",
+                   new_size);
+      std::abort();
+    }
+    return q;
+  }
+
+  void* q = Allocate(new_size);
+  std::memcpy(q, p, old_size < new_size ? old_size : new_size);
+  Free(p, old_size);
+  return q;
+}
+
+// Runs before other static initializers of the library, which might create
+// mpz values: blocks from GMP's default allocator must never reach Free.
+struct Installer {
+  Installer() {
+    const char* env = std::getenv("TF_BIG_GMP_POOL");
+    if (env != nullptr && std::strcmp(env, "0") == 0) {
+      return;
+    }
+    mp_set_memory_functions(Allocate, Reallocate, Free);
+    pool_enabled = true;
+  }
+};
+
+Installer installer __attribute__((init_priority(101)));
+
+}  // namespace
+
+bool GmpPoolEnabled() { return pool_enabled; }
+
+GmpMemoryStats ReadGmpMemoryStats() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  int64_t bytes_freed = retired_bytes_freed;
+  GmpMemoryStats res = {retired_allocations, retired_pool_hits,
+                        retired_bytes_allocated, 0, 0};
+  for (const ThreadCache* cache : Registry()) {
+    res.allocations += cache->stats.allocations.Get();
+    res.pool_hits += cache->stats.pool_hits.Get();
+    res.bytes_allocated += cache->stats.bytes_allocated.Get();
+    res.bytes_cached += cache->stats.bytes_cached.Get();
+    bytes_freed += cache->stats.bytes_freed.Get();
+  }
+  res.bytes_in_use = res.bytes_allocated - bytes_freed;
+  return res;
+}
+
+}  // namespace tf_big
@@ -0,0 +1,43 @@
+#ifndef TF_BIG_CC_GMP_ALLOCATOR_H_
+#define TF_BIG_CC_GMP_ALLOCATOR_H_
+
+#include <cstdint>
+
+namespace tf_big {
+
+// GMP's memory functions are replaced, when the library is loaded, by ones
+// that keep freed blocks of up to 4 KiB in thread-local, power-of-two size
+// classes. Most elements of a big tensor are a few limbs long, so this turns
+// the malloc/free pair behind every temporary mpz and every element of a
+// freed tensor into a free-list push and pop. Each thread caches at most
+// 256 KiB per size class; larger blocks go straight to malloc.
+//
+// Setting the environment variable TF_BIG_GMP_POOL=0 keeps GMP's default
+// functions, e.g. to look for leaks with external tools.
+//
+// GMP is linked statically, so this only affects the mpz values created by
+// this library.
+
+struct GmpMemoryStats {
+  // Number of allocations made by GMP, and how many of those were served
+  // from a thread cache.
+  int64_t allocations;
+  int64_t pool_hits;
+  // Bytes requested by GMP over the life of the process, and those currently
+  // held by live values.
+  int64_t bytes_allocated;
+  int64_t bytes_in_use;
+  // Bytes of freed blocks kept in thread caches for reuse.
+  int64_t bytes_cached;
+};
+
+// Whether the pooled functions are installed.
+bool GmpPoolEnabled();
+
+// Sums the statistics of all threads; values are only approximately
+// consistent with each other while other threads allocate.
+GmpMemoryStats ReadGmpMemoryStats();
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_GMP_ALLOCATOR_H_
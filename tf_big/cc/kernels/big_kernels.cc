@@ -1,17 +1,43 @@
 #include <gmp.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/framework/variant_encode_decode.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/overflow.h"
+#include "tensorflow/core/util/work_sharder.h"
+#include "tf_big/cc/batch_montgomery.h"
 #include "tf_big/cc/big_tensor.h"
+#include "tf_big/cc/counters.h"
+#include "tf_big/cc/fixed_base.h"
+#include "tf_big/cc/gmp_allocator.h"
+#include "tf_big/cc/montgomery.h"
+#include "tf_big/cc/obfuscator_pool.h"
+#include "tf_big/cc/primes.h"
+#include "tf_big/cc/random.h"
 
 using namespace tensorflow;  // NOLINT
+using tf_big::BatchMontgomery;
 using tf_big::BigTensor;
+using tf_big::FixedBaseTable;
+using tf_big::LimbMatrix;
+using tf_big::MontgomeryContext;
+using tf_big::ObfuscatorPool;
 
 Status GetBigTensor(OpKernelContext* ctx, int index, const BigTensor** res) {
   const Tensor& input = ctx->input(index);
@@ -27,10 +53,348 @@ Status GetBigTensor(OpKernelContext* ctx, int index, const BigTensor** res) {
   return Status::OK();
 }
 
-template <typename T>
-class BigImportOp : public OpKernel {
+// Runs `work` over [0, total) on the device's CPU worker threads. The cost is
+// the estimated number of cycles per element and is used by `Shard` to pick a
+// sensible block size.
+void ParallelFor(OpKernelContext* ctx, int64 total, int64 cost_per_element,
+                 const std::function<void(int64, int64)>& work) {
+  tf_big::ScopedOpActivity::AddWork(total, total * cost_per_element);
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, total,
+        cost_per_element, work);
+}
+
+// Largest number of limbs used by any element of the tensor.
+int64 MaxLimbs(const BigTensor& t) {
+  if (t.storage() == BigTensor::kLimbs) {
+    return t.limbs().max_size();
+  }
+  auto data = t.value().data();
+  size_t max_limbs = 0;
+  for (Index i = 0; i < t.size(); i++) {
+    max_limbs = std::max(max_limbs, mpz_size(data[i].get_mpz_t()));
+  }
+  return max_limbs;
+}
+
+// Largest bit length of any element of the tensor.
+int64 MaxBits(const BigTensor& t) {
+  mpz_t view;
+  size_t max_bits = 0;
+  for (Index i = 0; i < t.size(); i++) {
+    max_bits = std::max(max_bits, mpz_sizeinbase(t.element(i, view), 2));
+  }
+  return max_bits;
+}
+
+// Rough cycle estimates for limb-wise and schoolbook-style operations on
+// operands of the given size; these only need to be right to within an order
+// of magnitude for sharding to behave well.
+int64 LinearCost(int64 limbs) { return 50 + 5 * limbs; }
+int64 QuadraticCost(int64 limbs) { return 50 + 5 * limbs * limbs; }
+
+// Describes a kernel invocation for the profiler, using TraceMe's
+// "name#key=value,...#" metadata encoding: the largest number of elements,
+// the longest operand in bits, and the bytes of limbs held by the big tensor
+// inputs.
+string TraceMeName(OpKernelContext* ctx) {
+  int64 elements = 0;
+  int64 max_bits = 0;
+  int64 bytes = 0;
+  for (int i = 0; i < ctx->num_inputs(); i++) {
+    const Tensor& input = ctx->input(i);
+    if (ctx->input_dtype(i) != DT_VARIANT || input.NumElements() == 0) {
+      continue;
+    }
+    const BigTensor* big = input.flat<Variant>()(0).get<BigTensor>();
+    if (big == nullptr) {
+      continue;
+    }
+    elements = std::max<int64>(elements, big->size());
+    max_bits = std::max(max_bits, MaxBits(*big));
+    bytes += big->size() * MaxLimbs(*big) * sizeof(mp_limb_t);
+  }
+  const OpKernel& kernel = ctx->op_kernel();
+  return strings::StrCat(kernel.name(), ":", kernel.type_string(),
+                         "#elements=", elements, ",max_bits=", max_bits,
+                         ",bytes=", bytes, "#");
+}
+
+// Wraps a kernel so that every call is added to the process-wide counters of
+// its op type and, while the profiler is active, shows up as a TraceMe span.
+// The span's metadata is only computed when it is actually recorded.
+template <typename Kernel>
+class Instrumented : public Kernel {
+ public:
+  explicit Instrumented(OpKernelConstruction* ctx)
+      : Kernel(ctx), counters_(tf_big::Counters::Get(this->type_string())) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    profiler::TraceMe trace([ctx] { return TraceMeName(ctx); },
+                            /*level=*/2);
+    tf_big::ScopedOpActivity activity(counters_);
+    Kernel::Compute(ctx);
+  }
+
+ private:
+  tf_big::OpCounters* counters_;
+};
+
+// Computes the NumPy-style broadcast of two matrix shapes: each dimension
+// must either match or be one in one of the operands.
+Status BroadcastShape(const BigTensor& x, const BigTensor& y, Index* rows,
+                      Index* cols) {
+  auto broadcast_dim = [](Index a, Index b, Index* res) {
+    if (a != b && a != 1 && b != 1) {
+      return false;
+    }
+    *res = a == 1 ? b : a;
+    return true;
+  };
+  if (!broadcast_dim(x.rows(), y.rows(), rows) ||
+      !broadcast_dim(x.cols(), y.cols(), cols)) {
+    return errors::InvalidArgument("operands could not be broadcast together ",
+                                   "with shapes ", x.shape().DebugString(),
+                                   " and ", y.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+// Maps flat indices of a `rows` x `cols` broadcast result to flat indices of
+// an operand, without materializing the expanded operand. Both use
+// column-major order like MatrixXm.
+class BroadcastIndex {
+ public:
+  BroadcastIndex(const BigTensor& operand, Index rows, Index cols)
+      : rows_(rows),
+        identity_(operand.rows() == rows && operand.cols() == cols),
+        row_stride_(operand.rows() == 1 ? 0 : 1),
+        col_stride_(operand.cols() == 1 ? 0 : operand.rows()) {}
+
+  Index operator()(Index i) const {
+    if (identity_) {
+      return i;
+    }
+    return (i % rows_) * row_stride_ + (i / rows_) * col_stride_;
+  }
+
+ private:
+  Index rows_;
+  bool identity_;
+  Index row_stride_;
+  Index col_stride_;
+};
+
+// Allocates output 0 as a `rows` x `cols` big tensor in mpz storage and
+// returns its elements. Instead of allocating, one of the `candidates`
+// inputs is forwarded to the output and overwritten when it has that shape
+// and mpz storage, TF holds no other reference to its buffer, and its
+// storage is not shared with another big tensor; GMP allows results to alias
+// operands, so elementwise kernels can then compute in place.
+Status ForwardOrAllocateOutput(OpKernelContext* ctx,
+                               const std::vector<int>& candidates, Index rows,
+                               Index cols, MatrixXm** res) {
+  std::vector<int> forwardable;
+  for (int index : candidates) {
+    const BigTensor* big = nullptr;
+    TF_RETURN_IF_ERROR(GetBigTensor(ctx, index, &big));
+    if (big->storage() == BigTensor::kMpz && big->rows() == rows &&
+        big->cols() == cols && big->unique()) {
+      forwardable.push_back(index);
+    }
+  }
+
+  Tensor* output;
+  int forwarded = -1;
+  TF_RETURN_IF_ERROR(ctx->forward_input_or_allocate_output(
+      forwardable, 0, TensorShape{rows, cols}, &output, &forwarded));
+  Variant& variant = output->flat<Variant>()(0);
+  if (forwarded < 0) {
+    variant = BigTensor(MatrixXm(rows, cols));
+  }
+  *res = variant.get<BigTensor>()->mutable_value();
+  return Status::OK();
+}
+
+// Computes `op(res, x, y)` for every pair of elements, broadcasting the
+// operands against each other and sharding over the CPU worker threads, and
+// sets the result as output 0. `x` and `y` must be inputs 0 and 1, either of
+// which may be updated in place. `op` has the signature of e.g. `mpz_add`.
+template <typename Op>
+Status BinaryElementwise(OpKernelContext* ctx, const BigTensor& x,
+                         const BigTensor& y, int64 cost_per_element, Op op) {
+  Index rows, cols;
+  TF_RETURN_IF_ERROR(BroadcastShape(x, y, &rows, &cols));
+  BroadcastIndex x_index(x, rows, cols);
+  BroadcastIndex y_index(y, rows, cols);
+
+  MatrixXm* res;
+  TF_RETURN_IF_ERROR(ForwardOrAllocateOutput(ctx, {0, 1}, rows, cols, &res));
+  auto res_data = res->data();
+
+  ParallelFor(ctx, res->size(), cost_per_element,
+              [&](int64 start, int64 limit) {
+                mpz_t x_view, y_view;
+                for (int64 i = start; i < limit; i++) {
+                  op(res_data[i].get_mpz_t(), x.element(x_index(i), x_view),
+                     y.element(y_index(i), y_view));
+                }
+              });
+
+  return Status::OK();
+}
+
+// Limb storage counterpart of `BinaryElementwise`, computing directly on the
+// packed limbs with `op` from `tf_big::limb_ops`. The result has `width` limbs
+// per element, which must be enough for every result. The limb functions do
+// not allow aliasing, so the result is always freshly allocated.
+template <typename Op>
+Status BinaryElementwiseLimbs(OpKernelContext* ctx, const BigTensor& x,
+                              const BigTensor& y, mp_size_t width,
+                              int64 cost_per_element, Op op) {
+  Index rows, cols;
+  TF_RETURN_IF_ERROR(BroadcastShape(x, y, &rows, &cols));
+  BroadcastIndex x_index(x, rows, cols);
+  BroadcastIndex y_index(y, rows, cols);
+
+  const LimbMatrix& x_limbs = x.limbs();
+  const LimbMatrix& y_limbs = y.limbs();
+  LimbMatrix res_limbs(rows, cols, width);
+
+  ParallelFor(ctx, res_limbs.size(), cost_per_element,
+              [&](int64 start, int64 limit) {
+                for (int64 i = start; i < limit; i++) {
+                  Index xi = x_index(i);
+                  Index yi = y_index(i);
+                  res_limbs.set_signed_size(
+                      i, op(res_limbs.limbs(i), x_limbs.limbs(xi),
+                            x_limbs.signed_size(xi), y_limbs.limbs(yi),
+                            y_limbs.signed_size(yi)));
+                }
+              });
+
+  Tensor* output;
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output(0, TensorShape{rows, cols}, &output));
+  output->flat<Variant>()(0) = BigTensor(std::move(res_limbs));
+  return Status::OK();
+}
+
+// Looks up the Montgomery context for the modulus given as input `index`.
+Status GetMontgomeryContext(OpKernelContext* ctx, int index,
+                            std::shared_ptr<const MontgomeryContext>* res) {
+  const BigTensor* mod = nullptr;
+  TF_RETURN_IF_ERROR(GetBigTensor(ctx, index, &mod));
+
+  mpz_t view;
+  auto modulus = mod->element(0, view);
+  if (mpz_cmp_ui(modulus, 1) <= 0 || mpz_even_p(modulus)) {
+    return errors::InvalidArgument(
+        "Montgomery arithmetic requires an odd modulus greater than one");
+  }
+
+  *res = MontgomeryContext::Get(modulus);
+  return Status::OK();
+}
+
+// Per-thread scratch space for the Montgomery kernels, sized for moduli of
+// `n` limbs.
+struct MontgomeryWorkspace {
+  explicit MontgomeryWorkspace(mp_size_t n) : a(n), b(n), tp(2 * n) {}
+
+  std::vector<mp_limb_t> a;
+  std::vector<mp_limb_t> b;
+  std::vector<mp_limb_t> tp;
+  std::vector<mp_limb_t> pow;
+  mpz_class tmp;
+};
+
+// Computes every element of a `rows` x `cols` result with `fn(i, rp, ws)`,
+// where `rp` is the n-limb slot for element i and `ws` per-thread scratch.
+// The result uses limb storage with the width of the modulus.
+template <typename Fn>
+BigTensor MontgomeryElementwise(OpKernelContext* ctx,
+                                const MontgomeryContext& mont, Index rows,
+                                Index cols, int64 cost_per_element, Fn fn) {
+  auto n = mont.size();
+  LimbMatrix res(rows, cols, n);
+
+  ParallelFor(ctx, res.size(), cost_per_element,
+              [&](int64 start, int64 limit) {
+                MontgomeryWorkspace ws(n);
+                for (int64 i = start; i < limit; i++) {
+                  fn(i, res.limbs(i), &ws);
+                  res.set_signed_size(
+                      i, tf_big::limb_ops::Normalize(res.limbs(i), n));
+                }
+              });
+
+  return BigTensor(std::move(res));
+}
+
+// Runs `fn(first, count, ws)` over [0, total) in batches of up to
+// `batch.lanes()` consecutive elements, where `ws` is per-thread scratch.
+// Work is sharded by whole batches so that every lane is used.
+template <typename Fn>
+void ParallelForBatches(OpKernelContext* ctx, const BatchMontgomery& batch,
+                        int64 total, int64 cost_per_element, Fn fn) {
+  int64 lanes = batch.lanes();
+  tf_big::ScopedOpActivity::AddWork(total, total * cost_per_element);
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        (total + lanes - 1) / lanes, lanes * cost_per_element,
+        [&](int64 start, int64 limit) {
+          BatchMontgomery::Workspace ws;
+          for (int64 j = start; j < limit; j++) {
+            int64 first = j * lanes;
+            fn(first, static_cast<int>(std::min(lanes, total - first)), &ws);
+          }
+        });
+}
+
+// Text formats for string tensors: "decimal" and "hex" are signed numbers in
+// base 10 and 16 (no prefix), while "bytes" holds the magnitude as raw
+// big-endian bytes and is only defined for non-negative values.
+enum StringFormat { kDecimal, kHex, kBytes };
+
+Status ParseStringFormat(const string& name, StringFormat* format) {
+  if (name == "decimal") {
+    *format = kDecimal;
+  } else if (name == "hex") {
+    *format = kHex;
+  } else if (name == "bytes") {
+    *format = kBytes;
+  } else {
+    return errors::InvalidArgument("Unknown string format '", name, "'");
+  }
+  return Status::OK();
+}
+
+// Rough cost of converting a number of `length` digits or bytes; decimal
+// conversion is superlinear but this is only used for sharding.
+int64 StringCost(int64 length, StringFormat format) {
+  return format == kDecimal ? 50 + length * (1 + length / 64) : 50 + length;
+}
+
+// Number of limbs that holds any number written with `length` characters:
+// eight bits per byte, four per hex digit and under 3.322 per decimal digit.
+mp_size_t StringLimbs(size_t length, StringFormat format) {
+  size_t bits = format == kBytes ? 8 * length
+                : format == kHex ? 4 * length
+                                 : (length * 3322 + 999) / 1000;
+  return std::max<mp_size_t>((bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS, 1);
+}
+
+class BigImportStringOp : public OpKernel {
  public:
-  explicit BigImportOp(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit BigImportStringOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    string storage;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("storage", &storage));
+    OP_REQUIRES_OK(ctx, BigTensor::ParseStorage(storage, &storage_));
+    string format;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("string_format", &format));
+    OP_REQUIRES_OK(ctx, ParseStringFormat(format, &format_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor& input = ctx->input(0);
@@ -39,136 +403,447 @@ class BigImportOp : public OpKernel {
                     "value expected to be a matrix ",
                     "but got shape: ", input.shape().DebugString()));
 
-    Tensor* val;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &val));
+    auto rows = input.dim_size(0);
+    auto cols = input.dim_size(1);
+    auto data = input.flat<tstring>().data();
+    int64 length = rows * cols > 0 ? data[0].size() : 0;
 
+    // Limb storage is sized from the longest string, which bounds the
+    // magnitude of every element, so that elements are parsed into a
+    // per-thread temporary and packed without one mpz per element.
+    bool limbs = storage_ == BigTensor::kLimbs;
     BigTensor big;
-    big.FromTensor<T>(input);
+    if (limbs) {
+      size_t max_length = 0;
+      for (int64 e = 0; e < rows * cols; e++) {
+        max_length = std::max(max_length, data[e].size());
+      }
+      big = BigTensor(
+          LimbMatrix(rows, cols, StringLimbs(max_length, format_)));
+    } else {
+      big = BigTensor(MatrixXm(rows, cols));
+    }
+    LimbMatrix* res_limbs = limbs ? big.mutable_limbs() : nullptr;
+    MatrixXm* res_value = limbs ? nullptr : big.mutable_value();
+    std::atomic<bool> malformed(false);
+
+    // The input is row-major while big tensors are column-major.
+    ParallelFor(ctx, rows * cols, StringCost(length, format_),
+                [&](int64 start, int64 limit) {
+                  std::string buffer;
+                  mpz_class tmp;
+                  for (int64 e = start; e < limit; e++) {
+                    const tstring& str = data[e];
+                    Index i = (e / cols) + (e % cols) * rows;
+                    mpz_ptr res = limbs ? tmp.get_mpz_t()
+                                        : res_value->data()[i].get_mpz_t();
+                    if (format_ == kBytes) {
+                      mpz_import(res, str.size(), 1, sizeof(char), 0, 0,
+                                 str.data());
+                    } else {
+                      buffer.assign(str.data(), str.size());
+                      int base = format_ == kHex ? 16 : 10;
+                      if (mpz_set_str(res, buffer.c_str(), base) != 0) {
+                        malformed = true;
+                        return;
+                      }
+                    }
+                    if (limbs) {
+                      res_limbs->set(i, res);
+                    }
+                  }
+                });
+    OP_REQUIRES(ctx, !malformed,
+                errors::InvalidArgument("could not parse value as a ",
+                                        format_ == kHex ? "hex" : "decimal",
+                                        " number"));
 
+    Tensor* val;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &val));
     val->flat<Variant>()(0) = std::move(big);
   }
+
+ private:
+  BigTensor::Storage storage_;
+  StringFormat format_;
 };
 
+// Imports machine integers by writing their magnitude straight into a single
+// limb, avoiding a round trip through decimal strings.
 template <typename T>
-class BigImportLimbsOp : public OpKernel {
+class BigImportIntegerOp : public OpKernel {
  public:
-  explicit BigImportLimbsOp(OpKernelConstruction* context)
-      : OpKernel(context) {}
+  explicit BigImportIntegerOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    string storage;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("storage", &storage));
+    OP_REQUIRES_OK(ctx, BigTensor::ParseStorage(storage, &storage_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
+    static_assert(sizeof(T) <= sizeof(mp_limb_t),
+                  "integer dtypes must fit in a single limb");
+
     const Tensor& input = ctx->input(0);
-    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrixOrHigher(input.shape()),
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(input.shape()),
                 errors::InvalidArgument(
-                    "value expected to be at least a matrix ",
+                    "value expected to be a matrix ",
                     "but got shape: ", input.shape().DebugString()));
 
+    auto rows = input.dim_size(0);
+    auto cols = input.dim_size(1);
+    BigTensor big = storage_ == BigTensor::kLimbs
+                        ? BigTensor(LimbMatrix(rows, cols, 1))
+                        : BigTensor(MatrixXm(rows, cols));
+    bool limbs = storage_ == BigTensor::kLimbs;
+    LimbMatrix* res_limbs = limbs ? big.mutable_limbs() : nullptr;
+    MatrixXm* res_value = limbs ? nullptr : big.mutable_value();
+
+    // The input is row-major while big tensors are column-major.
+    auto data = input.flat<T>().data();
+    ParallelFor(ctx, rows * cols, LinearCost(1),
+                [&](int64 start, int64 limit) {
+                  for (int64 e = start; e < limit; e++) {
+                    T x = data[e];
+                    mp_limb_t magnitude = static_cast<mp_limb_t>(x);
+                    if (x < T(0)) {
+                      magnitude = -magnitude;
+                    }
+                    mp_size_t size = magnitude == 0 ? 0 : (x < T(0) ? -1 : 1);
+
+                    Index i = (e / cols) + (e % cols) * rows;
+                    if (limbs) {
+                      res_limbs->limbs(i)[0] = magnitude;
+                      res_limbs->set_signed_size(i, size);
+                    } else {
+                      mpz_ptr res = res_value->data()[i].get_mpz_t();
+                      mpz_limbs_write(res, 1)[0] = magnitude;
+                      mpz_limbs_finish(res, size);
+                    }
+                  }
+                });
+
     Tensor* val;
-    OP_REQUIRES_OK(ctx,
-                   ctx->allocate_output(0,
-                                        TensorShape{input.shape().dim_size(0),
-                                                    input.shape().dim_size(1)},
-                                        &val));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input.shape(), &val));
+    val->flat<Variant>()(0) = std::move(big);
+  }
 
-    BigTensor big;
-    big.LimbsFromTensor<T>(input);
+ private:
+  BigTensor::Storage storage_;
+};
+
+// Limb tensors have shape [rows, cols, num_words] and come in two layouts.
+// "header" prefixes each element with its byte length (4 bytes, little-endian)
+// followed by its magnitude as big-endian bytes. "fixed" has no header and
+// holds the magnitude as native-endian words of the tensor's dtype, least
+// significant first, so that with 64-bit words it matches GMP's limbs exactly.
+enum LimbLayout { kHeaderLayout, kFixedLayout };
+
+const size_t kLimbHeaderBytes = 4;
+
+Status ParseLimbLayout(const string& name, LimbLayout* layout) {
+  if (name == "header") {
+    *layout = kHeaderLayout;
+  } else if (name == "fixed") {
+    *layout = kFixedLayout;
+  } else {
+    return errors::InvalidArgument("Unknown limb layout '", name, "'");
+  }
+  return Status::OK();
+}
+
+// Decodes one `entry_bytelen`-byte entry of a limb tensor into `res`. Returns
+// false if a header claims more bytes than the entry holds.
+template <typename T>
+bool DecodeLimbEntry(mpz_ptr res, const uint8_t* entry, size_t entry_bytelen,
+                     LimbLayout layout) {
+  if (layout == kHeaderLayout) {
+    size_t length = tf_big::decode_length(entry);
+    if (length > entry_bytelen - kLimbHeaderBytes) {
+      return false;
+    }
+    mpz_import(res, length, 1, sizeof(uint8_t), 0, 0,
+               entry + kLimbHeaderBytes);
+  } else if (sizeof(T) == sizeof(mp_limb_t)) {
+    mp_size_t n = entry_bytelen / sizeof(mp_limb_t);
+    mp_limb_t* rp = mpz_limbs_write(res, std::max<mp_size_t>(n, 1));
+    std::memcpy(rp, entry, entry_bytelen);
+    mpz_limbs_finish(res, tf_big::limb_ops::Normalize(rp, n));
+  } else {
+    mpz_import(res, entry_bytelen / sizeof(T), -1, sizeof(T), 0, 0, entry);
+  }
+  return true;
+}
+
+template <typename T>
+class BigImportLimbsOp : public OpKernel {
+ public:
+  explicit BigImportLimbsOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    string storage;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("storage", &storage));
+    OP_REQUIRES_OK(ctx, BigTensor::ParseStorage(storage, &storage_));
+    string layout;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("layout", &layout));
+    OP_REQUIRES_OK(ctx, ParseLimbLayout(layout, &layout_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& input = ctx->input(0);
+    OP_REQUIRES(ctx, input.dims() == 3,
+                errors::InvalidArgument("value expected to be of rank 3 ",
+                                        "but got shape: ",
+                                        input.shape().DebugString()));
+
+    auto rows = input.dim_size(0);
+    auto cols = input.dim_size(1);
+    size_t entry_bytelen = input.dim_size(2) * sizeof(T);
+    size_t payload_bytelen = entry_bytelen;
+    if (layout_ == kHeaderLayout) {
+      OP_REQUIRES(ctx, entry_bytelen >= kLimbHeaderBytes,
+                  errors::InvalidArgument("limb entries of ", entry_bytelen,
+                                          " bytes cannot hold a header"));
+      payload_bytelen -= kLimbHeaderBytes;
+    }
+    mp_size_t width =
+        (payload_bytelen + sizeof(mp_limb_t) - 1) / sizeof(mp_limb_t);
+
+    BigTensor big = storage_ == BigTensor::kLimbs
+                        ? BigTensor(LimbMatrix(rows, cols, width))
+                        : BigTensor(MatrixXm(rows, cols));
+    bool limbs = storage_ == BigTensor::kLimbs;
+    LimbMatrix* res_limbs = limbs ? big.mutable_limbs() : nullptr;
+    MatrixXm* res_value = limbs ? nullptr : big.mutable_value();
+
+    const uint8_t* data =
+        reinterpret_cast<const uint8_t*>(input.flat<T>().data());
+    bool direct =
+        limbs && layout_ == kFixedLayout && sizeof(T) == sizeof(mp_limb_t);
+    std::atomic<bool> malformed(false);
+
+    // The input is row-major while big tensors are column-major.
+    ParallelFor(ctx, rows * cols, LinearCost(width),
+                [&](int64 start, int64 limit) {
+                  mpz_class tmp;
+                  for (int64 e = start; e < limit; e++) {
+                    const uint8_t* entry = data + e * entry_bytelen;
+                    Index i = (e / cols) + (e % cols) * rows;
+                    if (direct) {
+                      mp_limb_t* rp = res_limbs->limbs(i);
+                      std::memcpy(rp, entry, entry_bytelen);
+                      res_limbs->set_signed_size(
+                          i, tf_big::limb_ops::Normalize(rp, width));
+                      continue;
+                    }
+                    mpz_ptr res = limbs ? tmp.get_mpz_t()
+                                        : res_value->data()[i].get_mpz_t();
+                    if (!DecodeLimbEntry<T>(res, entry, entry_bytelen,
+                                            layout_)) {
+                      malformed = true;
+                      return;
+                    }
+                    if (limbs) {
+                      res_limbs->set(i, res);
+                    }
+                  }
+                });
+    OP_REQUIRES(ctx, !malformed,
+                errors::InvalidArgument("limb header exceeds entry length of ",
+                                        payload_bytelen, " bytes"));
 
+    Tensor* val;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape{rows, cols}, &val));
     val->flat<Variant>()(0) = std::move(big);
   }
+
+ private:
+  BigTensor::Storage storage_;
+  LimbLayout layout_;
 };
 
-template <typename T>
-class BigExportOp : public OpKernel {
+class BigExportStringOp : public OpKernel {
  public:
-  explicit BigExportOp(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit BigExportStringOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    string format;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("string_format", &format));
+    OP_REQUIRES_OK(ctx, ParseStringFormat(format, &format_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const BigTensor* val = nullptr;
-    TensorShape input_shape = ctx->input(0).shape();
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
 
+    auto rows = val->rows();
+    auto cols = val->cols();
     Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, input_shape, &output));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, ctx->input(0).shape(), &output));
+
+    int base = format_ == kBytes ? 256 : (format_ == kHex ? 16 : 10);
+    int64 length = (MaxLimbs(*val) * GMP_NUMB_BITS) / (base == 10 ? 3 : 4);
+    auto data = output->flat<tstring>().data();
+    std::atomic<bool> negative(false);
+
+    // The output is row-major while big tensors are column-major.
+    ParallelFor(ctx, rows * cols, StringCost(length, format_),
+                [&](int64 start, int64 limit) {
+                  mpz_t view;
+                  std::string buffer;
+                  for (int64 e = start; e < limit; e++) {
+                    auto x = val->element((e / cols) + (e % cols) * rows, view);
+                    size_t size;
+                    if (format_ == kBytes) {
+                      if (mpz_sgn(x) < 0) {
+                        negative = true;
+                        return;
+                      }
+                      buffer.resize((mpz_sizeinbase(x, 2) + 7) / 8);
+                      mpz_export(&buffer[0], &size, 1, sizeof(char), 0, 0, x);
+                    } else {
+                      // Room for a sign and the terminating null.
+                      buffer.resize(mpz_sizeinbase(x, base) + 2);
+                      mpz_get_str(&buffer[0], base, x);
+                      size = std::strlen(buffer.c_str());
+                    }
+                    data[e].assign(buffer.data(), size);
+                  }
+                });
+    OP_REQUIRES(ctx, !negative,
+                errors::InvalidArgument(
+                    "negative values cannot be exported as bytes"));
+  }
+
+ private:
+  StringFormat format_;
+};
+
+// Exports to machine integers from the lowest limb. By default values wrap
+// modulo 2^bits like a C cast; with `checked` set, values outside the range
+// of the dtype are an error instead.
+template <typename T>
+class BigExportIntegerOp : public OpKernel {
+ public:
+  explicit BigExportIntegerOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("checked", &checked_));
+  }
 
-    val->ToTensor<T>(output);
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    auto rows = val->rows();
+    auto cols = val->cols();
+    Tensor* output;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, ctx->input(0).shape(), &output));
+
+    // Largest magnitude representable for each sign.
+    mp_limb_t max_positive = std::numeric_limits<T>::max();
+    mp_limb_t max_negative =
+        -static_cast<mp_limb_t>(std::numeric_limits<T>::min());
+
+    auto data = output->flat<T>().data();
+    std::atomic<bool> overflow(false);
+    ParallelFor(ctx, rows * cols, LinearCost(1),
+                [&](int64 start, int64 limit) {
+                  mpz_t view;
+                  for (int64 e = start; e < limit; e++) {
+                    auto x = val->element((e / cols) + (e % cols) * rows, view);
+                    bool negative = mpz_sgn(x) < 0;
+                    mp_limb_t magnitude = mpz_getlimbn(x, 0);
+                    mp_limb_t bound = negative ? max_negative : max_positive;
+                    if (checked_ && (mpz_size(x) > 1 || magnitude > bound)) {
+                      overflow = true;
+                      return;
+                    }
+                    data[e] = static_cast<T>(negative ? -magnitude : magnitude);
+                  }
+                });
+    OP_REQUIRES(ctx, !overflow,
+                errors::InvalidArgument("value out of range for ",
+                                        DataTypeString(output->dtype())));
   }
+
+ private:
+  bool checked_;
 };
 
 template <typename T>
 class BigExportLimbsOp : public OpKernel {
  public:
-  explicit BigExportLimbsOp(OpKernelConstruction* context)
-      : OpKernel(context) {}
+  explicit BigExportLimbsOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    string layout;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("layout", &layout));
+    OP_REQUIRES_OK(ctx, ParseLimbLayout(layout, &layout_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor& maxval_tensor = ctx->input(1);
     int32_t max_bitlen = maxval_tensor.flat<int32>()(0);
 
     const BigTensor* input = nullptr;
-    TensorShape input_shape = ctx->input(0).shape();
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &input));
 
     // Compute maxval if left unspecified by user
     if (max_bitlen < 0) {
-      for (int i = 0; i < input->rows(); i++) {
-        for (int j = 0; j < input->cols(); j++) {
-          auto ele = input->value(i, j).get_mpz_t();
-          int32_t ele_bitlen = mpz_sizeinbase(ele, 2);
-          if (max_bitlen < ele_bitlen) {
-            max_bitlen = ele_bitlen;
-          }
-        }
-      }
+      max_bitlen = MaxBits(*input);
     }
     OP_REQUIRES(ctx, max_bitlen >= 0,
                 errors::Internal("Malformed max bitlength: ", max_bitlen));
-    unsigned int max_bytelen = max_bitlen * 8;
-
-    unsigned int header_bytelen = 4;
-    unsigned int header_bitlen = header_bytelen * 8;
-    unsigned int entry_bitlen = header_bitlen + max_bitlen;
-    unsigned int type_bitlen = sizeof(T) * 8;
-    unsigned int num_limbs = (entry_bitlen + type_bitlen - 1) / type_bitlen;
-    unsigned int entry_bytelen = num_limbs * sizeof(T);
+    size_t max_bytelen = (max_bitlen + 7) / 8;
 
-    TensorShape output_shape;
-    output_shape.AddDim(input_shape.dim_size(0));
-    output_shape.AddDim(input_shape.dim_size(1));
-    output_shape.AddDim(num_limbs);
+    size_t header_bitlen = layout_ == kHeaderLayout ? 8 * kLimbHeaderBytes : 0;
+    size_t entry_bitlen = header_bitlen + max_bitlen;
+    size_t type_bitlen = sizeof(T) * 8;
+    size_t num_words =
+        std::max<size_t>((entry_bitlen + type_bitlen - 1) / type_bitlen, 1);
+    size_t entry_bytelen = num_words * sizeof(T);
 
+    auto rows = input->rows();
+    auto cols = input->cols();
     Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
-    auto output_flattened = output->flat<T>();
-    uint8_t* output_data = reinterpret_cast<uint8_t*>(output_flattened.data());
-
-    size_t pointer = 0;
-    for (int i = 0; i < input->rows(); i++) {
-      for (int j = 0; j < input->cols(); j++) {
-        auto ele = input->value(i, j).get_mpz_t();
-
-        // Write header to output buffer
-        unsigned int ele_bytelen = mpz_sizeinbase(ele, 256);
-        tf_big::encode_length(output_data + pointer, ele_bytelen);
-        OP_REQUIRES(
-            ctx, ele_bytelen <= max_bytelen,
-            errors::Internal("User selected wrong byte length, required: ",
-                             ele_bytelen, " bytes"));
-
-        // Write element to output buffer
-        size_t exported_bytelen;
-        mpz_export(output_data + pointer + header_bytelen, &exported_bytelen, 1,
-                   sizeof(uint8_t), 0, 0, ele);
-
-        // Zero-out remaining bytes of entry
-        for (size_t k = header_bytelen + exported_bytelen; k < entry_bytelen;
-             k++) {
-          output_data[pointer + k] = 0;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            0, TensorShape{rows, cols, int64(num_words)},
+                            &output));
+    uint8_t* data = reinterpret_cast<uint8_t*>(output->flat<T>().data());
+    std::atomic<bool> overflow(false);
+
+    // The output is row-major while big tensors are column-major.
+    auto cost = LinearCost(entry_bytelen / sizeof(mp_limb_t));
+    ParallelFor(ctx, rows * cols, cost, [&](int64 start, int64 limit) {
+      mpz_t view;
+      for (int64 e = start; e < limit; e++) {
+        uint8_t* entry = data + e * entry_bytelen;
+        auto ele = input->element((e / cols) + (e % cols) * rows, view);
+
+        size_t ele_bytelen = mpz_sgn(ele) == 0 ? 0 : mpz_sizeinbase(ele, 256);
+        if (ele_bytelen > max_bytelen) {
+          overflow = true;
+          return;
         }
 
-        // Advance pointer to next entry
-        pointer += entry_bytelen;
+        size_t written;
+        if (layout_ == kHeaderLayout) {
+          tf_big::encode_length(entry, ele_bytelen);
+          mpz_export(entry + kLimbHeaderBytes, &written, 1, sizeof(uint8_t), 0,
+                     0, ele);
+          written += kLimbHeaderBytes;
+        } else if (sizeof(T) == sizeof(mp_limb_t)) {
+          written = mpz_size(ele) * sizeof(mp_limb_t);
+          std::memcpy(entry, mpz_limbs_read(ele), written);
+        } else {
+          mpz_export(entry, &written, -1, sizeof(T), 0, 0, ele);
+          written *= sizeof(T);
+        }
+        std::memset(entry + written, 0, entry_bytelen - written);
       }
-    }
+    });
+    OP_REQUIRES(ctx, !overflow,
+                errors::InvalidArgument("value does not fit in max_bitlen = ",
+                                        max_bitlen, " bits"));
   }
+
+ private:
+  LimbLayout layout_;
 };
 
 class BigAddOp : public OpKernel {
@@ -182,12 +857,18 @@ class BigAddOp : public OpKernel {
     const BigTensor* val1 = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val1));
 
-    Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val0->shape(), &output));
-
-    auto res = *val0 + *val1;
-
-    output->flat<Variant>()(0) = std::move(res);
+    auto x_width = MaxLimbs(*val0);
+    auto y_width = MaxLimbs(*val1);
+    auto cost = LinearCost(std::max(x_width, y_width));
+
+    if (val0->storage() == BigTensor::kLimbs &&
+        val1->storage() == BigTensor::kLimbs) {
+      auto width = std::max(x_width, y_width) + 1;
+      OP_REQUIRES_OK(ctx, BinaryElementwiseLimbs(ctx, *val0, *val1, width, cost,
+                                                 tf_big::limb_ops::Add));
+    } else {
+      OP_REQUIRES_OK(ctx, BinaryElementwise(ctx, *val0, *val1, cost, mpz_add));
+    }
   }
 };
 
@@ -202,12 +883,18 @@ class BigSubOp : public OpKernel {
     const BigTensor* val1 = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val1));
 
-    Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val0->shape(), &output));
-
-    auto res = *val0 - *val1;
-
-    output->flat<Variant>()(0) = std::move(res);
+    auto x_width = MaxLimbs(*val0);
+    auto y_width = MaxLimbs(*val1);
+    auto cost = LinearCost(std::max(x_width, y_width));
+
+    if (val0->storage() == BigTensor::kLimbs &&
+        val1->storage() == BigTensor::kLimbs) {
+      auto width = std::max(x_width, y_width) + 1;
+      OP_REQUIRES_OK(ctx, BinaryElementwiseLimbs(ctx, *val0, *val1, width, cost,
+                                                 tf_big::limb_ops::Sub));
+    } else {
+      OP_REQUIRES_OK(ctx, BinaryElementwise(ctx, *val0, *val1, cost, mpz_sub));
+    }
   }
 };
 
@@ -222,12 +909,18 @@ class BigMulOp : public OpKernel {
     const BigTensor* val1 = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val1));
 
-    Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val0->shape(), &output));
-
-    auto res = (*val0).cwiseProduct(*val1);
-
-    output->flat<Variant>()(0) = std::move(res);
+    auto x_width = MaxLimbs(*val0);
+    auto y_width = MaxLimbs(*val1);
+    auto cost = QuadraticCost(std::max(x_width, y_width));
+
+    if (val0->storage() == BigTensor::kLimbs &&
+        val1->storage() == BigTensor::kLimbs) {
+      auto width = x_width + y_width;
+      OP_REQUIRES_OK(ctx, BinaryElementwiseLimbs(ctx, *val0, *val1, width, cost,
+                                                 tf_big::limb_ops::Mul));
+    } else {
+      OP_REQUIRES_OK(ctx, BinaryElementwise(ctx, *val0, *val1, cost, mpz_mul));
+    }
   }
 };
 
@@ -242,12 +935,9 @@ class BigDivOp : public OpKernel {
     const BigTensor* val1 = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val1));
 
-    Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val0->shape(), &output));
-
-    auto res = (*val0).cwiseQuotient(*val1);
-
-    output->flat<Variant>()(0) = std::move(res);
+    auto limbs = std::max(MaxLimbs(*val0), MaxLimbs(*val1));
+    OP_REQUIRES_OK(ctx, BinaryElementwise(ctx, *val0, *val1,
+                                          QuadraticCost(limbs), mpz_tdiv_q));
   }
 };
 
@@ -268,38 +958,272 @@ class BigPowOp : public OpKernel {
     const BigTensor* modulus_t = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 2, &modulus_t));
 
-    Tensor* output;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, base->shape(), &output));
-
-    auto exponent = exponent_t->value.data();
-    auto modulus = modulus_t->value(0, 0);
-
-    MatrixXm res(base->rows(), base->cols());
-    auto v = base->value.data();
-    auto size = base->value.size();
-
-    mpz_t tmp;
-    mpz_init(tmp);
-    for (int i = 0; i < size; i++) {
-      if (secure) {
-        mpz_powm_sec(tmp, v[i].get_mpz_t(), exponent[i].get_mpz_t(),
-                     modulus.get_mpz_t());
-      } else {
-        mpz_powm(tmp, v[i].get_mpz_t(), exponent[i].get_mpz_t(),
-                 modulus.get_mpz_t());
-      }
+    Index rows, cols;
+    OP_REQUIRES_OK(ctx, BroadcastShape(*base, *exponent_t, &rows, &cols));
+    BroadcastIndex base_index(*base, rows, cols);
+    BroadcastIndex exponent_index(*exponent_t, rows, cols);
+
+    mpz_t modulus_view;
+    auto modulus = modulus_t->element(0, modulus_view);
 
-      res.data()[i] = mpz_class(tmp);
+    // Each element costs one multiplication per exponent bit.
+    auto cost = QuadraticCost(mpz_size(modulus)) * MaxBits(*exponent_t);
+
+    MatrixXm* res;
+    OP_REQUIRES_OK(ctx, ForwardOrAllocateOutput(ctx, {0, 1}, rows, cols, &res));
+    auto res_data = res->data();
+
+    // Batches of elements are vectorized when that beats GMP, except for
+    // secure exponentiations since the table lookups are not constant time.
+    std::shared_ptr<const BatchMontgomery> batch;
+    if (!secure) {
+      batch = BatchMontgomery::Get(modulus, BatchMontgomery::kPow);
+    }
+    if (batch != nullptr) {
+      ParallelForBatches(
+          ctx, *batch, res->size(), cost,
+          [&](int64 first, int count, BatchMontgomery::Workspace* ws) {
+            mpz_t base_views[BatchMontgomery::kMaxLanes];
+            mpz_t exponent_views[BatchMontgomery::kMaxLanes];
+            mpz_ptr r[BatchMontgomery::kMaxLanes];
+            mpz_srcptr b[BatchMontgomery::kMaxLanes];
+            mpz_srcptr e[BatchMontgomery::kMaxLanes];
+            bool negative = false;
+            for (int l = 0; l < count; l++) {
+              r[l] = res_data[first + l].get_mpz_t();
+              b[l] = base->element(base_index(first + l), base_views[l]);
+              e[l] = exponent_t->element(exponent_index(first + l),
+                                         exponent_views[l]);
+              negative |= mpz_sgn(e[l]) < 0;
+            }
+            // Negative exponents need an inverse, which GMP takes care of.
+            if (negative) {
+              for (int l = 0; l < count; l++) {
+                mpz_powm(r[l], b[l], e[l], modulus);
+              }
+              return;
+            }
+            batch->Pow(r, b, e, count, ws);
+          });
+      return;
     }
-    mpz_clear(tmp);
 
-    output->flat<Variant>()(0) = BigTensor(res);
+    ParallelFor(ctx, res->size(), cost, [&](int64 start, int64 limit) {
+      mpz_t base_view, exponent_view;
+      for (int64 i = start; i < limit; i++) {
+        auto b = base->element(base_index(i), base_view);
+        auto e = exponent_t->element(exponent_index(i), exponent_view);
+        if (secure) {
+          mpz_powm_sec(res_data[i].get_mpz_t(), b, e, modulus);
+        } else {
+          mpz_powm(res_data[i].get_mpz_t(), b, e, modulus);
+        }
+      }
+    });
   }
 
  private:
   bool secure = false;
 };
 
+// A prime power factor m = p^k of a CRT modulus, with k one or two, together
+// with its totient phi(m) = p^(k-1) (p - 1).
+struct CrtFactor {
+  CrtFactor(mpz_srcptr p, bool squared) : prime(p), modulus(p), phi(p) {
+    phi -= 1;
+    if (squared) {
+      modulus *= prime;
+      phi *= prime;
+    }
+  }
+
+  // r = b^e mod m for a non-negative exponent. The base is reduced modulo m
+  // and, unless p divides it and Euler's theorem does not apply, the exponent
+  // modulo phi(m), so that the exponentiation is done at half size.
+  void Pow(mpz_ptr r, mpz_srcptr b, mpz_srcptr e, bool secure, mpz_ptr b_tmp,
+           mpz_ptr e_tmp) const {
+    mpz_mod(b_tmp, b, modulus.get_mpz_t());
+    if (!mpz_divisible_p(b_tmp, prime.get_mpz_t())) {
+      mpz_mod(e_tmp, e, phi.get_mpz_t());
+      e = e_tmp;
+    }
+    // mpz_powm_sec requires a positive exponent and an odd modulus
+    if (secure && mpz_sgn(e) > 0 && mpz_odd_p(modulus.get_mpz_t())) {
+      mpz_powm_sec(r, b_tmp, e, modulus.get_mpz_t());
+    } else {
+      mpz_powm(r, b_tmp, e, modulus.get_mpz_t());
+    }
+  }
+
+  mpz_class prime;
+  mpz_class modulus;
+  mpz_class phi;
+};
+
+// Computes base^exponent modulo n = p q, or modulo n^2 when `squared` is set,
+// from the factorization of n: one exponentiation is done modulo each of the
+// prime powers and the two results are recombined with Garner's formula
+// r = r_q + m_q ((r_p - r_q) m_q^-1 mod m_p). The result uses limb storage
+// with the width of the modulus.
+class BigPowCrtOp : public OpKernel {
+ public:
+  explicit BigPowCrtOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("secure", &secure_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("squared", &squared_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* base = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &base));
+
+    const BigTensor* exponent = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &exponent));
+
+    const BigTensor* p_t = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 2, &p_t));
+
+    const BigTensor* q_t = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 3, &q_t));
+
+    Index rows, cols;
+    OP_REQUIRES_OK(ctx, BroadcastShape(*base, *exponent, &rows, &cols));
+    BroadcastIndex base_index(*base, rows, cols);
+    BroadcastIndex exponent_index(*exponent, rows, cols);
+
+    mpz_t view;
+    for (Index i = 0; i < exponent->size(); i++) {
+      OP_REQUIRES(ctx, mpz_sgn(exponent->element(i, view)) >= 0,
+                  errors::InvalidArgument("exponents must be non-negative"));
+    }
+
+    mpz_t p_view, q_view;
+    auto p = p_t->element(0, p_view);
+    auto q = q_t->element(0, q_view);
+    OP_REQUIRES(ctx, mpz_cmp_ui(p, 1) > 0 && mpz_cmp_ui(q, 1) > 0,
+                errors::InvalidArgument("p and q must be greater than one"));
+
+    CrtFactor fp(p, squared_);
+    CrtFactor fq(q, squared_);
+    mpz_class q_inv;
+    OP_REQUIRES(ctx,
+                mpz_invert(q_inv.get_mpz_t(), fq.modulus.get_mpz_t(),
+                           fp.modulus.get_mpz_t()) != 0,
+                errors::InvalidArgument("p and q must be coprime"));
+
+    mpz_class n = fp.modulus * fq.modulus;
+    LimbMatrix res(rows, cols, mpz_size(n.get_mpz_t()));
+
+    // Two exponentiations at half size, each with exponents no longer than
+    // the totient.
+    auto half = std::max(mpz_size(fp.modulus.get_mpz_t()),
+                         mpz_size(fq.modulus.get_mpz_t()));
+    auto bits = std::min<int64>(MaxBits(*exponent),
+                                mpz_sizeinbase(n.get_mpz_t(), 2));
+    auto cost = 2 * QuadraticCost(half) * bits;
+
+    ParallelFor(ctx, res.size(), cost, [&](int64 start, int64 limit) {
+      mpz_class rp, rq, b_tmp, e_tmp;
+      mpz_t base_view, exponent_view;
+      for (int64 i = start; i < limit; i++) {
+        auto b = base->element(base_index(i), base_view);
+        auto e = exponent->element(exponent_index(i), exponent_view);
+        fp.Pow(rp.get_mpz_t(), b, e, secure_, b_tmp.get_mpz_t(),
+               e_tmp.get_mpz_t());
+        fq.Pow(rq.get_mpz_t(), b, e, secure_, b_tmp.get_mpz_t(),
+               e_tmp.get_mpz_t());
+
+        mpz_sub(rp.get_mpz_t(), rp.get_mpz_t(), rq.get_mpz_t());
+        mpz_mul(rp.get_mpz_t(), rp.get_mpz_t(), q_inv.get_mpz_t());
+        mpz_mod(rp.get_mpz_t(), rp.get_mpz_t(), fp.modulus.get_mpz_t());
+        mpz_addmul(rq.get_mpz_t(), rp.get_mpz_t(), fq.modulus.get_mpz_t());
+        res.set(i, rq.get_mpz_t());
+      }
+    });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape{rows, cols}, &output));
+    output->flat<Variant>()(0) = BigTensor(std::move(res));
+  }
+
+ private:
+  bool secure_ = false;
+  bool squared_ = false;
+};
+
+// Side length of the square output tiles the matrix products are parallelized
+// over, and of the blocks of the inner dimension walked within each tile.
+const Index kMatMulTile = 32;
+
+// Checks that `x` and `y` can be multiplied as matrices.
+Status CheckMatMulShapes(const BigTensor& x, const BigTensor& y) {
+  if (x.cols() != y.rows()) {
+    return errors::InvalidArgument(
+        "Matrix size-incompatible: In[0]: ", x.shape().DebugString(),
+        ", In[1]: ", y.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+// Runs `fn(i0, i1, j0, j1, scratch)` for every output tile of the product of
+// `x` and `y`, sharded over the CPU worker threads; the tile covers rows
+// [i0, i1) and columns [j0, j1). With `use_scratch`, `scratch` is a
+// tile-sized block that is reused across the tiles of a shard, and otherwise
+// nullptr. `cost_per_product` is the cost of one multiply-add.
+template <typename Fn>
+void ForEachMatMulTile(OpKernelContext* ctx, const BigTensor& x,
+                       const BigTensor& y, int64 cost_per_product,
+                       bool use_scratch, Fn fn) {
+  auto rows = x.rows();
+  auto cols = y.cols();
+  auto row_tiles = (rows + kMatMulTile - 1) / kMatMulTile;
+  auto col_tiles = (cols + kMatMulTile - 1) / kMatMulTile;
+  auto cost = x.cols() * kMatMulTile * kMatMulTile * cost_per_product;
+
+  ParallelFor(ctx, row_tiles * col_tiles, cost, [&](int64 start,
+                                                    int64 limit) {
+    std::vector<mpz_class> scratch(use_scratch ? kMatMulTile * kMatMulTile
+                                               : 0);
+    for (int64 tile = start; tile < limit; tile++) {
+      Index i0 = (tile % row_tiles) * kMatMulTile;
+      Index j0 = (tile / row_tiles) * kMatMulTile;
+      fn(i0, std::min(i0 + kMatMulTile, rows), j0,
+         std::min(j0 + kMatMulTile, cols),
+         use_scratch ? scratch.data() : nullptr);
+    }
+  });
+}
+
+// Adds the product of rows [i0, i1) of `x` and columns [j0, j1) of `y` into
+// `acc`, a column-major block with leading dimension `stride` whose first
+// element is output element (i0, j0), using
+// mpz_addmul so that no temporaries are created. The inner dimension is
+// walked in blocks so that the operand elements touched stay in cache, and
+// the innermost loop runs down a column, which is contiguous in all operands.
+void MatMulTile(const BigTensor& x, const BigTensor& y, Index i0, Index i1,
+                Index j0, Index j1, mpz_class* acc, Index stride) {
+  auto rows = x.rows();
+  auto inner = x.cols();
+
+  mpz_t x_view, y_view;
+  for (Index k0 = 0; k0 < inner; k0 += kMatMulTile) {
+    Index k1 = std::min(k0 + kMatMulTile, inner);
+    for (Index j = j0; j < j1; j++) {
+      mpz_class* acc_col = acc + (j - j0) * stride;
+      for (Index k = k0; k < k1; k++) {
+        auto b = y.element(j * inner + k, y_view);
+        if (mpz_sgn(b) == 0) {
+          continue;
+        }
+        for (Index i = i0; i < i1; i++) {
+          mpz_addmul(acc_col[i - i0].get_mpz_t(),
+                     x.element(k * rows + i, x_view), b);
+        }
+      }
+    }
+  }
+}
+
 class BigMatMulOp : public OpKernel {
  public:
   explicit BigMatMulOp(OpKernelConstruction* context) : OpKernel(context) {}
@@ -311,51 +1235,85 @@ class BigMatMulOp : public OpKernel {
     const BigTensor* val2 = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val2));
 
-    Tensor* output;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(0, TensorShape{val1->rows(), val2->cols()},
-                                  &output));
+    OP_REQUIRES_OK(ctx, CheckMatMulShapes(*val1, *val2));
 
-    auto res = *val1 * *val2;
+    auto rows = val1->rows();
+    auto cols = val2->cols();
+    MatrixXm res(rows, cols);
+    auto res_data = res.data();
 
-    output->flat<Variant>()(0) = std::move(res);
+    auto limbs = std::max(MaxLimbs(*val1), MaxLimbs(*val2));
+    ForEachMatMulTile(ctx, *val1, *val2, QuadraticCost(limbs),
+                      /*use_scratch=*/false,
+                      [&](Index i0, Index i1, Index j0, Index j1,
+                          mpz_class* scratch) {
+                        MatMulTile(*val1, *val2, i0, i1, j0, j1,
+                                   res_data + j0 * rows + i0, rows);
+                      });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape{rows, cols}, &output));
+    output->flat<Variant>()(0) = BigTensor(std::move(res));
   }
 };
 
-class BigModOp : public OpKernel {
+// Computes `(x @ y) mod n` without materializing the unreduced product: each
+// tile is accumulated unreduced in per-shard scratch, which only grows by
+// log2 of the inner dimension over the operand products, and every element is
+// reduced once when its tile is done. The result uses limb storage with the
+// width of the modulus.
+class BigMatMulModOp : public OpKernel {
  public:
-  explicit BigModOp(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit BigMatMulModOp(OpKernelConstruction* context) : OpKernel(context) {}
 
   void Compute(OpKernelContext* ctx) override {
-    const BigTensor* val = nullptr;
-    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
-
-    const BigTensor* mod = nullptr;
-    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &mod));
-    auto modulus = mod->value(0, 0);
+    const BigTensor* val1 = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val1));
 
-    MatrixXm res_matrix(val->rows(), val->cols());
-    auto res_data = res_matrix.data();
-    auto val_data = val->value.data();
-    auto size = val->value.size();
+    const BigTensor* val2 = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val2));
 
-    mpz_t tmp;
-    mpz_init(tmp);
-    for (int i = 0; i < size; i++) {
-      mpz_mod(tmp, val_data[i].get_mpz_t(), modulus.get_mpz_t());
-      res_data[i] = mpz_class(tmp);
-    }
-    mpz_clear(tmp);
+    const BigTensor* mod = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 2, &mod));
+    mpz_t modulus_view;
+    auto modulus = mod->element(0, modulus_view);
+    OP_REQUIRES(ctx, mpz_sgn(modulus) > 0,
+                errors::InvalidArgument("modulus must be positive"));
+
+    OP_REQUIRES_OK(ctx, CheckMatMulShapes(*val1, *val2));
+
+    auto rows = val1->rows();
+    auto cols = val2->cols();
+    LimbMatrix res(rows, cols, mpz_size(modulus));
+
+    auto limbs = std::max(MaxLimbs(*val1), MaxLimbs(*val2));
+    ForEachMatMulTile(
+        ctx, *val1, *val2, QuadraticCost(limbs), /*use_scratch=*/true,
+        [&](Index i0, Index i1, Index j0, Index j1, mpz_class* acc) {
+          for (Index i = 0; i < kMatMulTile * kMatMulTile; i++) {
+            mpz_set_ui(acc[i].get_mpz_t(), 0);
+          }
+          MatMulTile(*val1, *val2, i0, i1, j0, j1, acc, kMatMulTile);
+          for (Index j = j0; j < j1; j++) {
+            for (Index i = i0; i < i1; i++) {
+              auto x = acc[(j - j0) * kMatMulTile + (i - i0)].get_mpz_t();
+              mpz_mod(x, x, modulus);
+              res.set(j * rows + i, x);
+            }
+          }
+        });
 
-    Tensor* res;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val->shape(), &res));
-    res->flat<Variant>()(0) = BigTensor(res_matrix);
+    Tensor* output;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape{rows, cols}, &output));
+    output->flat<Variant>()(0) = BigTensor(std::move(res));
   }
 };
 
-class BigInvOp : public OpKernel {
+class BigModOp : public OpKernel {
  public:
-  explicit BigInvOp(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit BigModOp(OpKernelConstruction* context) : OpKernel(context) {}
 
   void Compute(OpKernelContext* ctx) override {
     const BigTensor* val = nullptr;
@@ -363,176 +1321,1412 @@ class BigInvOp : public OpKernel {
 
     const BigTensor* mod = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &mod));
-    auto modulus = mod->value(0, 0);
+    mpz_t modulus_view;
+    auto modulus = mod->element(0, modulus_view);
+    auto limbs = static_cast<int64>(mpz_size(modulus));
 
-    MatrixXm res_matrix(val->rows(), val->cols());
-    auto res_data = res_matrix.data();
-    auto val_data = val->value.data();
-    auto size = val->value.size();
+    auto cost = QuadraticCost(std::max(MaxLimbs(*val), limbs));
 
-    mpz_t tmp;
-    mpz_init(tmp);
-    for (int i = 0; i < size; i++) {
-      mpz_invert(tmp, val_data[i].get_mpz_t(), modulus.get_mpz_t());
-      res_data[i] = mpz_class(tmp);
-    }
-    mpz_clear(tmp);
+    MatrixXm* res;
+    OP_REQUIRES_OK(ctx, ForwardOrAllocateOutput(ctx, {0}, val->rows(),
+                                                val->cols(), &res));
+    auto res_data = res->data();
 
-    Tensor* res;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val->shape(), &res));
-    res->flat<Variant>()(0) = BigTensor(res_matrix);
+    ParallelFor(ctx, val->size(), cost, [&](int64 start, int64 limit) {
+      mpz_t view;
+      for (int64 i = start; i < limit; i++) {
+        mpz_mod(res_data[i].get_mpz_t(), val->element(i, view), modulus);
+      }
+    });
   }
 };
 
-class BigRandomUniformOp : public OpKernel {
+// Sets res[i] to the inverse of element i of `val` modulo `modulus` for i in
+// [start, limit), or to zero where no inverse exists.
+void InvertEach(const BigTensor& val, mpz_srcptr modulus, mpz_class* res,
+                int64 start, int64 limit) {
+  mpz_t view;
+  for (int64 i = start; i < limit; i++) {
+    // mpz_invert leaves the result undefined when no inverse exists
+    if (!mpz_invert(res[i].get_mpz_t(), val.element(i, view), modulus)) {
+      mpz_set_ui(res[i].get_mpz_t(), 0);
+    }
+  }
+}
+
+// Same as `InvertEach` but with Montgomery's simultaneous inversion trick:
+// res[] first receives the running products a_start ... a_i mod n, a single
+// inversion of the last one gives the inverse of the whole product, and a
+// backward pass peels off one element at a time with two multiplications.
+// Elements divisible by the modulus are skipped and set to zero. If any other
+// element is not invertible the product is not either; the range is then
+// split in halves that are retried on their own, so that only the offending
+// elements end up with a failed inversion each.
+void InvertBatch(const BigTensor& val, mpz_srcptr modulus, mpz_class* res,
+                 int64 start, int64 limit) {
+  mpz_t view;
+  mpz_class acc(1);
+  for (int64 i = start; i < limit; i++) {
+    auto a = val.element(i, view);
+    if (!mpz_divisible_p(a, modulus)) {
+      mpz_mul(acc.get_mpz_t(), acc.get_mpz_t(), a);
+      mpz_mod(acc.get_mpz_t(), acc.get_mpz_t(), modulus);
+    }
+    res[i] = acc;
+  }
+
+  mpz_class inv;
+  if (!mpz_invert(inv.get_mpz_t(), acc.get_mpz_t(), modulus)) {
+    if (limit - start == 1) {
+      mpz_set_ui(res[start].get_mpz_t(), 0);
+      return;
+    }
+    int64 middle = start + (limit - start) / 2;
+    InvertBatch(val, modulus, res, start, middle);
+    InvertBatch(val, modulus, res, middle, limit);
+    return;
+  }
+
+  mpz_class tmp;
+  for (int64 i = limit - 1; i >= start; i--) {
+    auto a = val.element(i, view);
+    if (mpz_divisible_p(a, modulus)) {
+      mpz_set_ui(res[i].get_mpz_t(), 0);
+      continue;
+    }
+    // a_i^-1 = (a_start ... a_i)^-1 (a_start ... a_(i-1))
+    if (i > start) {
+      mpz_mul(tmp.get_mpz_t(), inv.get_mpz_t(), res[i - 1].get_mpz_t());
+      mpz_mod(tmp.get_mpz_t(), tmp.get_mpz_t(), modulus);
+    } else {
+      tmp = inv;
+    }
+    mpz_mul(inv.get_mpz_t(), inv.get_mpz_t(), a);
+    mpz_mod(inv.get_mpz_t(), inv.get_mpz_t(), modulus);
+    mpz_swap(res[i].get_mpz_t(), tmp.get_mpz_t());
+  }
+}
+
+class BigInvOp : public OpKernel {
+ public:
+  explicit BigInvOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("batched", &batched_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    const BigTensor* mod = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &mod));
+    mpz_t modulus_view;
+    auto modulus = mod->element(0, modulus_view);
+    OP_REQUIRES(ctx, mpz_sgn(modulus) > 0,
+                errors::InvalidArgument("modulus must be positive"));
+    auto limbs = static_cast<int64>(mpz_size(modulus));
+
+    MatrixXm res_matrix(val->rows(), val->cols());
+    auto res_data = res_matrix.data();
+    auto size = val->size();
+
+    if (batched_) {
+      // Three modular multiplications per element; the one inversion per
+      // shard is amortized over the shard.
+      auto cost = 6 * QuadraticCost(std::max(MaxLimbs(*val), limbs));
+      ParallelFor(ctx, size, cost, [&](int64 start, int64 limit) {
+        InvertBatch(*val, modulus, res_data, start, limit);
+      });
+    } else {
+      // Extended GCD is quadratic in the operand size with a large constant.
+      auto cost = 64 * QuadraticCost(limbs);
+      ParallelFor(ctx, size, cost, [&](int64 start, int64 limit) {
+        InvertEach(*val, modulus, res_data, start, limit);
+      });
+    }
+
+    Tensor* res;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val->shape(), &res));
+    res->flat<Variant>()(0) = BigTensor(std::move(res_matrix));
+  }
+
+ private:
+  bool batched_ = false;
+};
+
+// Reduces `val` along `axis`, or over all elements if `reduce_all`, and sets
+// the result as output 0 with the reduced dimension kept at size one. Each
+// accumulator starts out as `identity` and takes in elements, and other
+// accumulators, with `accumulate(acc, x)`.
+//
+// The reduction is a two-level tree: every reduction is split into chunks so
+// that the worker threads are kept busy even when there are only a few
+// reductions, and the chunk results are then combined per reduction.
+template <typename Accumulate>
+Status Reduce(OpKernelContext* ctx, const BigTensor& val, bool reduce_all,
+              int64 axis, const mpz_class& identity, int64 cost_per_element,
+              Accumulate accumulate) {
+  // Reduction o folds the elements o * outer + k * inner for k < length.
+  Index res_rows = reduce_all || axis == 0 ? 1 : val.rows();
+  Index res_cols = reduce_all || axis == 1 ? 1 : val.cols();
+  Index outputs = res_rows * res_cols;
+  Index length = outputs == 0 ? 0 : val.size() / outputs;
+  Index outer = reduce_all ? 0 : (axis == 0 ? val.rows() : 1);
+  Index inner = !reduce_all && axis == 1 ? val.rows() : 1;
+
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Index target_chunks = 4 * worker_threads->num_threads;
+  Index splits = 1;
+  if (outputs > 0 && outputs < target_chunks) {
+    splits = std::max<Index>(1, std::min(length, target_chunks / outputs));
+  }
+  Index chunk = (length + splits - 1) / splits;
+
+  std::vector<mpz_class> partials(outputs * splits, identity);
+  ParallelFor(ctx, partials.size(), chunk * cost_per_element,
+              [&](int64 start, int64 limit) {
+                mpz_t view;
+                for (int64 t = start; t < limit; t++) {
+                  Index o = t / splits;
+                  Index begin = (t % splits) * chunk;
+                  Index end = std::min(length, begin + chunk);
+                  mpz_ptr acc = partials[t].get_mpz_t();
+                  for (Index k = begin; k < end; k++) {
+                    accumulate(acc, val.element(o * outer + k * inner, view));
+                  }
+                }
+              });
+
+  MatrixXm res(res_rows, res_cols);
+  auto res_data = res.data();
+  ParallelFor(ctx, outputs, splits * cost_per_element,
+              [&](int64 start, int64 limit) {
+                for (int64 o = start; o < limit; o++) {
+                  mpz_ptr acc = res_data[o].get_mpz_t();
+                  mpz_swap(acc, partials[o * splits].get_mpz_t());
+                  for (Index t = 1; t < splits; t++) {
+                    accumulate(acc, partials[o * splits + t].get_mpz_t());
+                  }
+                }
+              });
+
+  Tensor* output;
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output(0, TensorShape{res_rows, res_cols}, &output));
+  output->flat<Variant>()(0) = BigTensor(std::move(res));
+  return Status::OK();
+}
+
+Status GetReduceAttrs(OpKernelConstruction* ctx, bool* reduce_all,
+                      int64* axis) {
+  TF_RETURN_IF_ERROR(ctx->GetAttr("reduce_all", reduce_all));
+  TF_RETURN_IF_ERROR(ctx->GetAttr("axis", axis));
+  if (!*reduce_all && *axis != 0 && *axis != 1) {
+    return errors::InvalidArgument("axis must be 0 or 1, got ", *axis);
+  }
+  return Status::OK();
+}
+
+class BigReduceSumOp : public OpKernel {
+ public:
+  explicit BigReduceSumOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetReduceAttrs(ctx, &reduce_all_, &axis_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    // Sums grow by at most a limb every 2^64 additions, so the cost is that
+    // of adding operands of the input size.
+    auto cost = LinearCost(MaxLimbs(*val));
+    OP_REQUIRES_OK(ctx, Reduce(ctx, *val, reduce_all_, axis_, mpz_class(0),
+                               cost, [](mpz_ptr acc, mpz_srcptr x) {
+                                 mpz_add(acc, acc, x);
+                               }));
+  }
+
+ private:
+  bool reduce_all_;
+  int64 axis_;
+};
+
+// Multiplies elements modulo `mod`, reducing after every multiplication so
+// that accumulators never exceed the modulus; with a Paillier modulus n^2
+// this sums the encrypted plaintexts.
+class BigReduceProdModOp : public OpKernel {
+ public:
+  explicit BigReduceProdModOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetReduceAttrs(ctx, &reduce_all_, &axis_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    const BigTensor* mod = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &mod));
+    mpz_t modulus_view;
+    auto modulus = mod->element(0, modulus_view);
+    OP_REQUIRES(ctx, mpz_sgn(modulus) > 0,
+                errors::InvalidArgument("modulus must be positive"));
+
+    mpz_class identity(1);
+    mpz_mod(identity.get_mpz_t(), identity.get_mpz_t(), modulus);
+
+    // A multiplication and a division per element.
+    auto limbs = std::max<int64>(MaxLimbs(*val), mpz_size(modulus));
+    auto cost = 2 * QuadraticCost(limbs);
+    OP_REQUIRES_OK(ctx, Reduce(ctx, *val, reduce_all_, axis_, identity, cost,
+                               [modulus](mpz_ptr acc, mpz_srcptr x) {
+                                 mpz_mul(acc, acc, x);
+                                 mpz_mod(acc, acc, modulus);
+                               }));
+  }
+
+ private:
+  bool reduce_all_;
+  int64 axis_;
+};
+
+// Builds a `rows` x `cols` big tensor from elements of `inputs` and sets it as
+// output 0, taking element i of the result from element `index` of input
+// `input` as set by `source(i, &input, &index)`. Elements are copied as limbs,
+// without any conversion. The result uses limb storage as wide as the widest
+// input if all inputs do, and mpz storage otherwise.
+template <typename Source>
+Status Rearrange(OpKernelContext* ctx,
+                 const std::vector<const BigTensor*>& inputs, Index rows,
+                 Index cols, Source source) {
+  bool limbs = true;
+  mp_size_t width = 0;
+  for (const BigTensor* input : inputs) {
+    limbs = limbs && input->storage() == BigTensor::kLimbs;
+    width = std::max<mp_size_t>(width, MaxLimbs(*input));
+  }
+
+  BigTensor res = limbs ? BigTensor(LimbMatrix(rows, cols, width))
+                        : BigTensor(MatrixXm(rows, cols));
+  LimbMatrix* res_limbs = limbs ? res.mutable_limbs() : nullptr;
+  MatrixXm* res_value = limbs ? nullptr : res.mutable_value();
+
+  ParallelFor(ctx, rows * cols, LinearCost(width),
+              [&](int64 start, int64 limit) {
+                mpz_t view;
+                for (int64 i = start; i < limit; i++) {
+                  int input;
+                  Index index;
+                  source(i, &input, &index);
+                  auto x = inputs[input]->element(index, view);
+                  if (limbs) {
+                    mp_size_t n = mpz_size(x);
+                    std::copy(mpz_limbs_read(x), mpz_limbs_read(x) + n,
+                              res_limbs->limbs(i));
+                    res_limbs->set_signed_size(i, mpz_sgn(x) < 0 ? -n : n);
+                  } else {
+                    mpz_set(res_value->data()[i].get_mpz_t(), x);
+                  }
+                }
+              });
+
+  Tensor* output;
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output(0, TensorShape{rows, cols}, &output));
+  output->flat<Variant>()(0) = std::move(res);
+  return Status::OK();
+}
+
+// Sets output 0 to a big tensor sharing the storage of `val`, for operations
+// that leave the elements and their layout unchanged.
+Status ShareStorage(OpKernelContext* ctx, const BigTensor& val) {
+  Tensor* output;
+  TF_RETURN_IF_ERROR(ctx->allocate_output(0, val.shape(), &output));
+  output->flat<Variant>()(0) = val;
+  return Status::OK();
+}
+
+Status GetAxis(OpKernelConstruction* ctx, int64* axis) {
+  TF_RETURN_IF_ERROR(ctx->GetAttr("axis", axis));
+  if (*axis != 0 && *axis != 1) {
+    return errors::InvalidArgument("axis must be 0 or 1, got ", *axis);
+  }
+  return Status::OK();
+}
+
+class BigSliceOp : public OpKernel {
+ public:
+  explicit BigSliceOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    const Tensor& begin_tensor = ctx->input(1);
+    const Tensor& size_tensor = ctx->input(2);
+    OP_REQUIRES(ctx,
+                begin_tensor.NumElements() == 2 &&
+                    size_tensor.NumElements() == 2,
+                errors::InvalidArgument(
+                    "begin and size must have two elements, got ",
+                    begin_tensor.NumElements(), " and ",
+                    size_tensor.NumElements()));
+
+    // A size of -1 extends the slice to the end of the dimension.
+    Index dims[] = {val->rows(), val->cols()};
+    Index begin[2], size[2];
+    for (int d = 0; d < 2; d++) {
+      begin[d] = begin_tensor.flat<int32>()(d);
+      size[d] = size_tensor.flat<int32>()(d);
+      if (size[d] == -1) {
+        size[d] = dims[d] - begin[d];
+      }
+      OP_REQUIRES(
+          ctx, 0 <= begin[d] && 0 <= size[d] && begin[d] + size[d] <= dims[d],
+          errors::InvalidArgument("slice of size ", size[d], " at ", begin[d],
+                                  " exceeds dimension ", d, " of size ",
+                                  dims[d]));
+    }
+
+    if (size[0] == dims[0] && size[1] == dims[1]) {
+      OP_REQUIRES_OK(ctx, ShareStorage(ctx, *val));
+      return;
+    }
+
+    Index rows = val->rows();
+    OP_REQUIRES_OK(
+        ctx, Rearrange(ctx, {val}, size[0], size[1],
+                       [&](Index i, int* input, Index* index) {
+                         *input = 0;
+                         *index = (begin[1] + i / size[0]) * rows + begin[0] +
+                                  i % size[0];
+                       }));
+  }
+};
+
+// Gathers rows (axis 0) or columns (axis 1) by index.
+template <typename T>
+class BigGatherOp : public OpKernel {
+ public:
+  explicit BigGatherOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetAxis(ctx, &axis_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    const Tensor& indices_t = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices_t.shape()),
+                errors::InvalidArgument("indices must be a vector, got shape ",
+                                        indices_t.shape().DebugString()));
+    auto indices = indices_t.flat<T>();
+    Index count = indices.size();
+    Index dim = axis_ == 0 ? val->rows() : val->cols();
+    for (Index k = 0; k < count; k++) {
+      OP_REQUIRES(ctx, 0 <= indices(k) && indices(k) < dim,
+                  errors::InvalidArgument("index ", indices(k), " at ", k,
+                                          " is out of range [0, ", dim, ")"));
+    }
+
+    Index rows = axis_ == 0 ? count : val->rows();
+    Index cols = axis_ == 0 ? val->cols() : count;
+    Index val_rows = val->rows();
+    OP_REQUIRES_OK(ctx, Rearrange(ctx, {val}, rows, cols,
+                                  [&](Index i, int* input, Index* index) {
+                                    Index r = i % rows;
+                                    Index c = i / rows;
+                                    if (axis_ == 0) {
+                                      r = indices(r);
+                                    } else {
+                                      c = indices(c);
+                                    }
+                                    *input = 0;
+                                    *index = c * val_rows + r;
+                                  }));
+  }
+
+ private:
+  int64 axis_;
+};
+
+class BigConcatOp : public OpKernel {
+ public:
+  explicit BigConcatOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, GetAxis(ctx, &axis_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    std::vector<const BigTensor*> inputs(ctx->num_inputs());
+    for (int k = 0; k < ctx->num_inputs(); k++) {
+      OP_REQUIRES_OK(ctx, GetBigTensor(ctx, k, &inputs[k]));
+    }
+    if (inputs.size() == 1) {
+      OP_REQUIRES_OK(ctx, ShareStorage(ctx, *inputs[0]));
+      return;
+    }
+
+    // Offsets of the inputs along the axis, with the total at the end.
+    std::vector<Index> offsets = {0};
+    Index other = axis_ == 0 ? inputs[0]->cols() : inputs[0]->rows();
+    for (const BigTensor* input : inputs) {
+      Index along = axis_ == 0 ? input->rows() : input->cols();
+      Index across = axis_ == 0 ? input->cols() : input->rows();
+      OP_REQUIRES(ctx, across == other,
+                  errors::InvalidArgument(
+                      "cannot concatenate shapes ",
+                      inputs[0]->shape().DebugString(), " and ",
+                      input->shape().DebugString(), " along axis ", axis_));
+      offsets.push_back(offsets.back() + along);
+    }
+
+    Index rows = axis_ == 0 ? offsets.back() : other;
+    Index cols = axis_ == 0 ? other : offsets.back();
+    OP_REQUIRES_OK(
+        ctx, Rearrange(ctx, inputs, rows, cols,
+                       [&](Index i, int* input, Index* index) {
+                         Index r = i % rows;
+                         Index c = i / rows;
+                         Index along = axis_ == 0 ? r : c;
+                         *input = std::upper_bound(offsets.begin() + 1,
+                                                   offsets.end(), along) -
+                                  offsets.begin() - 1;
+                         along -= offsets[*input];
+                         if (axis_ == 0) {
+                           r = along;
+                         } else {
+                           c = along;
+                         }
+                         *index = c * inputs[*input]->rows() + r;
+                       }));
+  }
+
+ private:
+  int64 axis_;
+};
+
+// Reshapes with the row-major semantics of NumPy and TF, so that elements
+// keep their order when read row by row. Big tensors are column-major, hence
+// only reshapes between vectors and to the same shape keep the layout.
+class BigReshapeOp : public OpKernel {
+ public:
+  explicit BigReshapeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    const Tensor& shape_t = ctx->input(1);
+    OP_REQUIRES(ctx, shape_t.NumElements() == 2,
+                errors::InvalidArgument("shape must have two elements, got ",
+                                        shape_t.NumElements()));
+    Index rows = shape_t.flat<int32>()(0);
+    Index cols = shape_t.flat<int32>()(1);
+    OP_REQUIRES(ctx, rows >= -1 && cols >= -1 && (rows != -1 || cols != -1),
+                errors::InvalidArgument("invalid shape [", rows, ", ", cols,
+                                        "]"));
+    if (rows == -1) {
+      rows = cols == 0 ? 0 : val->size() / cols;
+    } else if (cols == -1) {
+      cols = rows == 0 ? 0 : val->size() / rows;
+    }
+    OP_REQUIRES(ctx, rows * cols == val->size(),
+                errors::InvalidArgument("cannot reshape ",
+                                        val->shape().DebugString(), " to [",
+                                        rows, ", ", cols, "]"));
+
+    if (rows == val->rows() && cols == val->cols()) {
+      OP_REQUIRES_OK(ctx, ShareStorage(ctx, *val));
+      return;
+    }
+
+    Index val_rows = val->rows();
+    Index val_cols = val->cols();
+    OP_REQUIRES_OK(ctx, Rearrange(ctx, {val}, rows, cols,
+                                  [&](Index i, int* input, Index* index) {
+                                    // Position in row-major order.
+                                    Index p = (i % rows) * cols + i / rows;
+                                    *input = 0;
+                                    *index = (p % val_cols) * val_rows +
+                                             p / val_cols;
+                                  }));
+  }
+};
+
+class BigTransposeOp : public OpKernel {
+ public:
+  explicit BigTransposeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    Index rows = val->cols();
+    Index cols = val->rows();
+    OP_REQUIRES_OK(ctx, Rearrange(ctx, {val}, rows, cols,
+                                  [&](Index i, int* input, Index* index) {
+                                    *input = 0;
+                                    *index = (i % rows) * cols + i / rows;
+                                  }));
+  }
+};
+
+// Computes `op(x, y) mod n` elementwise with broadcasting, reducing every
+// element into a per-thread temporary as soon as it is produced so that the
+// unreduced intermediate is never materialized. The result uses limb storage
+// with the width of the modulus.
+template <typename Op>
+class BigModularBinaryOp : public OpKernel {
+ public:
+  explicit BigModularBinaryOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val0 = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val0));
+
+    const BigTensor* val1 = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val1));
+
+    const BigTensor* mod = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 2, &mod));
+    mpz_t modulus_view;
+    auto modulus = mod->element(0, modulus_view);
+    OP_REQUIRES(ctx, mpz_sgn(modulus) > 0,
+                errors::InvalidArgument("modulus must be positive"));
+
+    Index rows, cols;
+    OP_REQUIRES_OK(ctx, BroadcastShape(*val0, *val1, &rows, &cols));
+    BroadcastIndex index0(*val0, rows, cols);
+    BroadcastIndex index1(*val1, rows, cols);
+
+    Op op;
+    auto limbs = std::max<int64>(std::max(MaxLimbs(*val0), MaxLimbs(*val1)),
+                                 mpz_size(modulus));
+    LimbMatrix res(rows, cols, mpz_size(modulus));
+
+    std::shared_ptr<const BatchMontgomery> batch;
+    if (Op::kBatched) {
+      batch = BatchMontgomery::Get(modulus, BatchMontgomery::kMul);
+    }
+    if (batch != nullptr) {
+      ParallelForBatches(
+          ctx, *batch, res.size(), op.Cost(limbs),
+          [&](int64 first, int count, BatchMontgomery::Workspace* ws) {
+            mpz_class tmp[BatchMontgomery::kMaxLanes];
+            mpz_t views0[BatchMontgomery::kMaxLanes];
+            mpz_t views1[BatchMontgomery::kMaxLanes];
+            mpz_ptr r[BatchMontgomery::kMaxLanes];
+            mpz_srcptr x[BatchMontgomery::kMaxLanes];
+            mpz_srcptr y[BatchMontgomery::kMaxLanes];
+            for (int l = 0; l < count; l++) {
+              r[l] = tmp[l].get_mpz_t();
+              x[l] = val0->element(index0(first + l), views0[l]);
+              y[l] = val1->element(index1(first + l), views1[l]);
+            }
+            batch->Mul(r, x, y, count, ws);
+            for (int l = 0; l < count; l++) {
+              res.set(first + l, r[l]);
+            }
+          });
+    } else {
+      ParallelFor(ctx, res.size(), op.Cost(limbs),
+                  [&](int64 start, int64 limit) {
+                    mpz_class tmp;
+                    mpz_t view0, view1;
+                    for (int64 i = start; i < limit; i++) {
+                      op(tmp.get_mpz_t(), val0->element(index0(i), view0),
+                         val1->element(index1(i), view1));
+                      mpz_mod(tmp.get_mpz_t(), tmp.get_mpz_t(), modulus);
+                      res.set(i, tmp.get_mpz_t());
+                    }
+                  });
+    }
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape{rows, cols}, &output));
+    output->flat<Variant>()(0) = BigTensor(std::move(res));
+  }
+};
+
+// Products cost a multiplication and a division. Sums and differences of
+// reduced operands are only off by a small multiple of the modulus, so their
+// reduction is linear, and they are not worth batching either.
+struct ModularMul {
+  static const bool kBatched = true;
+  int64 Cost(int64 limbs) const { return 2 * QuadraticCost(limbs); }
+  void operator()(mpz_ptr rop, mpz_srcptr x, mpz_srcptr y) const {
+    mpz_mul(rop, x, y);
+  }
+};
+
+struct ModularAdd {
+  static const bool kBatched = false;
+  int64 Cost(int64 limbs) const { return 4 * LinearCost(limbs); }
+  void operator()(mpz_ptr rop, mpz_srcptr x, mpz_srcptr y) const {
+    mpz_add(rop, x, y);
+  }
+};
+
+struct ModularSub {
+  static const bool kBatched = false;
+  int64 Cost(int64 limbs) const { return 4 * LinearCost(limbs); }
+  void operator()(mpz_ptr rop, mpz_srcptr x, mpz_srcptr y) const {
+    mpz_sub(rop, x, y);
+  }
+};
+
+class BigToMontgomeryOp : public OpKernel {
+ public:
+  explicit BigToMontgomeryOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    std::shared_ptr<const MontgomeryContext> mont;
+    OP_REQUIRES_OK(ctx, GetMontgomeryContext(ctx, 1, &mont));
+
+    auto cost = QuadraticCost(std::max<int64>(MaxLimbs(*val), mont->size()));
+    auto res = MontgomeryElementwise(
+        ctx, *mont, val->rows(), val->cols(), cost,
+        [&](Index i, mp_limb_t* rp, MontgomeryWorkspace* ws) {
+          mpz_t view;
+          mont->ToMontgomery(rp, val->element(i, view), ws->tmp.get_mpz_t(),
+                             ws->tp.data());
+        });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val->shape(), &output));
+    output->flat<Variant>()(0) = std::move(res);
+  }
+};
+
+class BigFromMontgomeryOp : public OpKernel {
+ public:
+  explicit BigFromMontgomeryOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val));
+
+    std::shared_ptr<const MontgomeryContext> mont;
+    OP_REQUIRES_OK(ctx, GetMontgomeryContext(ctx, 1, &mont));
+
+    auto cost = QuadraticCost(mont->size());
+    auto res = MontgomeryElementwise(
+        ctx, *mont, val->rows(), val->cols(), cost,
+        [&](Index i, mp_limb_t* rp, MontgomeryWorkspace* ws) {
+          mpz_t view;
+          mont->Load(ws->a.data(), val->element(i, view), ws->tmp.get_mpz_t());
+          mont->FromMontgomery(rp, ws->a.data(), ws->tp.data());
+        });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, val->shape(), &output));
+    output->flat<Variant>()(0) = std::move(res);
+  }
+};
+
+// Elementwise binary operation on two tensors in the Montgomery domain, with
+// `Op` one of the limb-level members of MontgomeryContext.
+template <typename Op>
+class BigMontgomeryBinaryOp : public OpKernel {
+ public:
+  explicit BigMontgomeryBinaryOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* val0 = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &val0));
+
+    const BigTensor* val1 = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &val1));
+
+    Index rows, cols;
+    OP_REQUIRES_OK(ctx, BroadcastShape(*val0, *val1, &rows, &cols));
+    BroadcastIndex index0(*val0, rows, cols);
+    BroadcastIndex index1(*val1, rows, cols);
+
+    std::shared_ptr<const MontgomeryContext> mont;
+    OP_REQUIRES_OK(ctx, GetMontgomeryContext(ctx, 2, &mont));
+
+    Op op;
+    auto res = MontgomeryElementwise(
+        ctx, *mont, rows, cols, op.Cost(mont->size()),
+        [&](Index i, mp_limb_t* rp, MontgomeryWorkspace* ws) {
+          mpz_t view0, view1;
+          mont->Load(ws->a.data(), val0->element(index0(i), view0),
+                     ws->tmp.get_mpz_t());
+          mont->Load(ws->b.data(), val1->element(index1(i), view1),
+                     ws->tmp.get_mpz_t());
+          op(*mont, rp, ws->a.data(), ws->b.data(), ws->tp.data());
+        });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, res.shape(), &output));
+    output->flat<Variant>()(0) = std::move(res);
+  }
+};
+
+struct MontgomeryMul {
+  int64 Cost(int64 limbs) const { return QuadraticCost(limbs); }
+  void operator()(const MontgomeryContext& mont, mp_limb_t* rp,
+                  const mp_limb_t* ap, const mp_limb_t* bp,
+                  mp_limb_t* tp) const {
+    mont.Mul(rp, ap, bp, tp);
+  }
+};
+
+struct MontgomeryAdd {
+  int64 Cost(int64 limbs) const { return LinearCost(limbs); }
+  void operator()(const MontgomeryContext& mont, mp_limb_t* rp,
+                  const mp_limb_t* ap, const mp_limb_t* bp,
+                  mp_limb_t* tp) const {
+    mont.Add(rp, ap, bp);
+  }
+};
+
+struct MontgomerySub {
+  int64 Cost(int64 limbs) const { return LinearCost(limbs); }
+  void operator()(const MontgomeryContext& mont, mp_limb_t* rp,
+                  const mp_limb_t* ap, const mp_limb_t* bp,
+                  mp_limb_t* tp) const {
+    mont.Sub(rp, ap, bp);
+  }
+};
+
+class BigMontgomeryPowOp : public OpKernel {
  public:
-  explicit BigRandomUniformOp(OpKernelConstruction* context)
+  explicit BigMontgomeryPowOp(OpKernelConstruction* context)
       : OpKernel(context) {}
 
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* base = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &base));
+
+    const BigTensor* exponent = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &exponent));
+
+    Index rows, cols;
+    OP_REQUIRES_OK(ctx, BroadcastShape(*base, *exponent, &rows, &cols));
+    BroadcastIndex base_index(*base, rows, cols);
+    BroadcastIndex exponent_index(*exponent, rows, cols);
+
+    mpz_t view;
+    for (Index i = 0; i < exponent->size(); i++) {
+      OP_REQUIRES(ctx, mpz_sgn(exponent->element(i, view)) >= 0,
+                  errors::InvalidArgument("exponents must be non-negative"));
+    }
+
+    std::shared_ptr<const MontgomeryContext> mont;
+    OP_REQUIRES_OK(ctx, GetMontgomeryContext(ctx, 2, &mont));
+
+    auto cost = QuadraticCost(mont->size()) * MaxBits(*exponent);
+    auto res = MontgomeryElementwise(
+        ctx, *mont, rows, cols, cost,
+        [&](Index i, mp_limb_t* rp, MontgomeryWorkspace* ws) {
+          mpz_t base_view, exponent_view;
+          mont->Load(ws->a.data(), base->element(base_index(i), base_view),
+                     ws->tmp.get_mpz_t());
+          mont->Pow(rp, ws->a.data(),
+                    exponent->element(exponent_index(i), exponent_view),
+                    &ws->pow);
+        });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, res.shape(), &output));
+    output->flat<Variant>()(0) = std::move(res);
+  }
+};
+
+// Largest fixed-base table BigFixedBaseTable builds. The table size is set by
+// the op's inputs, so it is bounded before anything is allocated.
+const int64 kMaxFixedBaseTableBytes = int64{1} << 30;
+
+// Resource holding a FixedBaseTable so that it can be built once and then
+// shared by every BigPowFixedBase run against it.
+class FixedBaseTableResource : public ResourceBase {
+ public:
+  explicit FixedBaseTableResource(std::unique_ptr<FixedBaseTable> table)
+      : table_(std::move(table)) {}
+
+  string DebugString() const override { return "FixedBaseTable"; }
+
+  int64 MemoryUsed() const override { return table_->MemoryUsed(); }
+
+  const FixedBaseTable& table() const { return *table_; }
+
+ private:
+  std::unique_ptr<FixedBaseTable> table_;
+};
+
+class BigFixedBaseTableOp : public OpKernel {
+ public:
+  explicit BigFixedBaseTableOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("window", &window_));
+    OP_REQUIRES(ctx, window_ >= 1 && window_ <= 8,
+                errors::InvalidArgument("window must be between 1 and 8, got ",
+                                        window_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("container", &container_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shared_name", &shared_name_));
+    if (shared_name_.empty()) {
+      shared_name_ = name();
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* base_t = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &base_t));
+
+    const BigTensor* modulus_t = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &modulus_t));
+
+    int32 max_bitlen = ctx->input(2).scalar<int32>()();
+    OP_REQUIRES(ctx, max_bitlen > 0,
+                errors::InvalidArgument("max_bitlen must be positive, got ",
+                                        max_bitlen));
+
+    mpz_t base_view, modulus_view;
+    auto base = base_t->element(0, base_view);
+    auto modulus = modulus_t->element(0, modulus_view);
+    OP_REQUIRES(ctx, mpz_cmp_ui(modulus, 1) > 0 && mpz_odd_p(modulus),
+                errors::InvalidArgument("fixed-base tables require an odd ",
+                                        "modulus greater than one"));
+
+    // 2^window - 1 entries of the modulus width per window of max_bitlen;
+    // with the window at most 8 only the last product can overflow.
+    int64 positions = (int64{max_bitlen} + window_ - 1) / window_;
+    int64 entries = positions * ((int64{1} << window_) - 1);
+    int64 table_bytes = MultiplyWithoutOverflow(
+        entries, mpz_size(modulus) * sizeof(mp_limb_t));
+    OP_REQUIRES(ctx, table_bytes >= 0 && table_bytes <= kMaxFixedBaseTableBytes,
+                errors::InvalidArgument(
+                    "fixed-base table for max_bitlen = ", max_bitlen,
+                    " and window = ", window_, " would exceed ",
+                    kMaxFixedBaseTableBytes, " bytes"));
+
+    auto handle = MakeResourceHandle<FixedBaseTableResource>(ctx, container_,
+                                                             shared_name_);
+    FixedBaseTableResource* resource = nullptr;
+    OP_REQUIRES_OK(ctx, LookupOrCreateResource<FixedBaseTableResource>(
+                            ctx, handle, &resource,
+                            [&](FixedBaseTableResource** res) {
+                              *res = new FixedBaseTableResource(
+                                  std::unique_ptr<FixedBaseTable>(
+                                      new FixedBaseTable(base, modulus,
+                                                         max_bitlen, window_)));
+                              return Status::OK();
+                            }));
+    core::ScopedUnref unref(resource);
+
+    // The table is only built on the first run; later runs must agree with it.
+    OP_REQUIRES(ctx,
+                mpz_cmp(resource->table().base(), base) == 0 &&
+                    mpz_cmp(resource->table().modulus(), modulus) == 0,
+                errors::FailedPrecondition(
+                    "fixed-base table '", shared_name_,
+                    "' was built for a different base or modulus"));
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape{}, &output));
+    output->scalar<ResourceHandle>()() = handle;
+  }
+
+ private:
+  int window_;
+  string container_;
+  string shared_name_;
+};
+
+class BigPowFixedBaseOp : public OpKernel {
+ public:
+  explicit BigPowFixedBaseOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    FixedBaseTableResource* resource = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &resource));
+    core::ScopedUnref unref(resource);
+    const FixedBaseTable& table = resource->table();
+
+    const BigTensor* exponent = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &exponent));
+
+    mpz_t view;
+    for (Index i = 0; i < exponent->size(); i++) {
+      OP_REQUIRES(ctx, mpz_sgn(exponent->element(i, view)) >= 0,
+                  errors::InvalidArgument("exponents must be non-negative"));
+    }
+
+    // One multiplication per window of the exponent.
+    auto cost = QuadraticCost(table.context().size()) * MaxBits(*exponent) / 4;
+    auto res = MontgomeryElementwise(
+        ctx, table.context(), exponent->rows(), exponent->cols(), cost,
+        [&](Index i, mp_limb_t* rp, MontgomeryWorkspace* ws) {
+          mpz_t exponent_view;
+          table.Pow(rp, exponent->element(i, exponent_view), &ws->pow);
+        });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, exponent->shape(), &output));
+    output->flat<Variant>()(0) = std::move(res);
+  }
+};
+
+class ObfuscatorPoolResource : public ResourceBase {
+ public:
+  explicit ObfuscatorPoolResource(std::unique_ptr<ObfuscatorPool> pool)
+      : pool_(std::move(pool)) {}
+
+  string DebugString() const override { return "ObfuscatorPool"; }
+
+  int64 MemoryUsed() const override { return pool_->MemoryUsed(); }
+
+  ObfuscatorPool* pool() { return pool_.get(); }
+
+ private:
+  std::unique_ptr<ObfuscatorPool> pool_;
+};
+
+class BigObfuscatorPoolOp : public OpKernel {
+ public:
+  explicit BigObfuscatorPoolOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("capacity", &capacity_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("container", &container_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shared_name", &shared_name_));
+    if (shared_name_.empty()) {
+      shared_name_ = name();
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const BigTensor* modulus_t = nullptr;
+    OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 0, &modulus_t));
+
+    mpz_t modulus_view;
+    auto modulus = modulus_t->element(0, modulus_view);
+    OP_REQUIRES(ctx, mpz_cmp_ui(modulus, 1) > 0 && mpz_odd_p(modulus),
+                errors::InvalidArgument("obfuscator pools require an odd ",
+                                        "modulus greater than one"));
+
+    auto handle = MakeResourceHandle<ObfuscatorPoolResource>(ctx, container_,
+                                                             shared_name_);
+    ObfuscatorPoolResource* resource = nullptr;
+    OP_REQUIRES_OK(ctx, LookupOrCreateResource<ObfuscatorPoolResource>(
+                            ctx, handle, &resource,
+                            [&](ObfuscatorPoolResource** res) {
+                              tf_big::ChaChaStream::Key key;
+                              if (!tf_big::RandomKey(&key)) {
+                                return errors::Unavailable(
+                                    "could not read system randomness");
+                              }
+                              *res = new ObfuscatorPoolResource(
+                                  std::unique_ptr<ObfuscatorPool>(
+                                      new ObfuscatorPool(modulus, capacity_,
+                                                         key)));
+                              return Status::OK();
+                            }));
+    core::ScopedUnref unref(resource);
+
+    // The pool is only started on the first run; later runs must agree with it.
+    OP_REQUIRES(ctx, mpz_cmp(resource->pool()->modulus(), modulus) == 0,
+                errors::FailedPrecondition("obfuscator pool '", shared_name_,
+                                           "' was created for a different ",
+                                           "modulus"));
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape{}, &output));
+    output->scalar<ResourceHandle>()() = handle;
+  }
+
+ private:
+  int capacity_;
+  string container_;
+  string shared_name_;
+};
+
+// Takes as many obfuscators as are ready from the pool and computes the rest
+// on the spot, so that it never blocks on the producer.
+class BigObfuscatorPoolPopOp : public OpKernel {
+ public:
+  explicit BigObfuscatorPoolPopOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    ObfuscatorPoolResource* resource = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &resource));
+    core::ScopedUnref unref(resource);
+    ObfuscatorPool* pool = resource->pool();
+
+    TensorShape shape;
+    OP_REQUIRES_OK(ctx, tensor::MakeShape(ctx->input(1), &shape));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(shape),
+                errors::InvalidArgument("shape expected to be a matrix ",
+                                        "but got: ", shape.DebugString()));
+
+    auto width = pool->width();
+    LimbMatrix res(shape.dim_size(0), shape.dim_size(1), width);
+    int64 popped = res.size() > 0 ? pool->Pop(res.limbs(0), res.size()) : 0;
+
+    if (popped < res.size()) {
+      tf_big::ChaChaStream::Key key;
+      OP_REQUIRES(ctx, tf_big::RandomKey(&key),
+                  errors::Unavailable("could not read system randomness"));
+
+      // One exponentiation modulo n^2 with an exponent of half that size.
+      auto cost = QuadraticCost(width) * mpz_sizeinbase(pool->modulus(), 2);
+      ParallelFor(ctx, res.size() - popped, cost,
+                  [&](int64 start, int64 limit) {
+                    for (int64 i = start; i < limit; i++) {
+                      tf_big::ChaChaStream stream(key, i);
+                      pool->Compute(res.limbs(popped + i), &stream);
+                    }
+                  });
+    }
+
+    for (Index i = 0; i < res.size(); i++) {
+      res.set_signed_size(i, tf_big::limb_ops::Normalize(res.limbs(i), width));
+    }
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, shape, &output));
+    output->flat<Variant>()(0) = BigTensor(std::move(res));
+  }
+};
+
+// Draws every element from its own ChaCha20 stream, so that generation can be
+// sharded freely and, when seeded, the output does not depend on how the work
+// was split. Element i uses nonce `stream` starting at block i * 2^32.
+class BigRandomUniformOp : public OpKernel {
+ public:
+  explicit BigRandomUniformOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    std::vector<int64> seed;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("seed", &seed));
+    OP_REQUIRES(ctx, seed.size() <= 4,
+                errors::InvalidArgument("seed can have at most four elements"));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("stream", &stream_));
+
+    seeded_ = !seed.empty();
+    key_.fill(0);
+    for (size_t i = 0; i < seed.size(); i++) {
+      auto word = static_cast<uint64>(seed[i]);
+      key_[2 * i] = static_cast<uint32_t>(word);
+      key_[2 * i + 1] = static_cast<uint32_t>(word >> 32);
+    }
+  }
+
   void Compute(OpKernelContext* ctx) override {
     const Tensor& shape_tensor = ctx->input(0);
     TensorShape shape;
     OP_REQUIRES_OK(ctx, tensor::MakeShape(shape_tensor, &shape));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(shape),
+                errors::InvalidArgument("shape expected to be a matrix ",
+                                        "but got: ", shape.DebugString()));
 
     const BigTensor* maxval_tensor = nullptr;
     OP_REQUIRES_OK(ctx, GetBigTensor(ctx, 1, &maxval_tensor));
-    auto maxval = maxval_tensor->value(0, 0).get_mpz_t();
-
-    MatrixXm res_matrix(shape.dim_size(0), shape.dim_size(1));
-    auto res_data = res_matrix.data();
-    auto size = res_matrix.size();
-
-    // TODO(Morten) offer secure randomness
-    gmp_randstate_t state;
-    tf_big::gmp_utils::init_randstate(state);
-    mpz_t tmp;
-    mpz_init(tmp);
-    for (int i = 0; i < size; i++) {
-      mpz_urandomm(tmp, state, maxval);
-      res_data[i] = mpz_class(tmp);
+    mpz_t maxval_view;
+    auto maxval = maxval_tensor->element(0, maxval_view);
+    OP_REQUIRES(ctx, mpz_sgn(maxval) > 0,
+                errors::InvalidArgument("maxval must be positive"));
+
+    auto key = key_;
+    if (!seeded_) {
+      OP_REQUIRES(ctx, tf_big::RandomKey(&key),
+                  errors::Unavailable("could not read system randomness"));
     }
-    mpz_clear(tmp);
 
-    Tensor* res;
-    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, shape, &res));
-    res->flat<Variant>()(0) = BigTensor(res_matrix);
+    auto n = mpz_size(maxval);
+    auto bound = mpz_limbs_read(maxval);
+    LimbMatrix res(shape.dim_size(0), shape.dim_size(1), n);
+
+    // One ChaCha20 block yields eight limbs and costs a few hundred cycles.
+    auto cost = 300 * ((n + 7) / 8) + 100;
+    ParallelFor(ctx, res.size(), cost, [&](int64 start, int64 limit) {
+      for (int64 i = start; i < limit; i++) {
+        tf_big::ChaChaStream stream(key, stream_, static_cast<uint64>(i) << 32);
+        tf_big::RandomBelow(res.limbs(i), bound, n, &stream);
+        res.set_signed_size(i, tf_big::limb_ops::Normalize(res.limbs(i), n));
+      }
+    });
+
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, shape, &output));
+    output->flat<Variant>()(0) = BigTensor(std::move(res));
   }
+
+ private:
+  bool seeded_ = false;
+  tf_big::ChaChaStream::Key key_;
+  int64 stream_ = 0;
 };
 
+// Rough cost of searching for one prime, large enough that the searches are
+// always spread over the worker threads one by one.
+const int64 kPrimeSearchCost = int64{1} << 32;
+
 class BigRandomRsaModulusOp : public OpKernel {
  public:
-  explicit BigRandomRsaModulusOp(OpKernelConstruction* context)
-      : OpKernel(context) {}
+  explicit BigRandomRsaModulusOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("batch_size", &batch_size_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor& bitlength_t = ctx->input(0);
-    auto bitlength = bitlength_t.scalar<int32>();
-    auto bitlength_val = bitlength.data();
-
-    MatrixXm p_matrix(1, 1);
+    auto bitlength = bitlength_t.scalar<int32>()();
+    OP_REQUIRES(ctx, bitlength >= 16,
+                errors::InvalidArgument("bitlength must be at least 16, got ",
+                                        bitlength));
+
+    // p and q have their two top bits set, so n has exactly `bitlength` bits.
+    size_t p_bits = bitlength - bitlength / 2;
+    size_t q_bits = bitlength / 2;
+
+    MatrixXm p_matrix(batch_size_, 1);
+    MatrixXm q_matrix(batch_size_, 1);
+    MatrixXm n_matrix(batch_size_, 1);
     auto p_data = p_matrix.data();
-    MatrixXm q_matrix(1, 1);
     auto q_data = q_matrix.data();
-    MatrixXm n_matrix(1, 1);
     auto n_data = n_matrix.data();
 
-    gmp_randstate_t state;
-    tf_big::gmp_utils::init_randstate(state);
-    mpz_t p;
-    mpz_t q;
-    mpz_t n;
-    mpz_init(p);
-    mpz_init(q);
-    mpz_init(n);
-
-    do {
-      do {
-        mpz_urandomb(p, state, *bitlength_val / 2);
-      } while (!mpz_probab_prime_p(p, 10));
-
-      do {
-        mpz_urandomb(q, state, *bitlength_val / 2);
-      } while (!mpz_probab_prime_p(q, 10));
-
-      mpz_mul(n, p, q);
-    } while (!mpz_tstbit(n, *bitlength_val - 1));
-
-    p_data[0] = mpz_class(p);
-    q_data[0] = mpz_class(q);
-    n_data[0] = mpz_class(n);
+    // Key material, so the candidates come from ChaCha20 keyed from the
+    // system's entropy source. All 2 * batch_size primes are searched for
+    // independently, each on its own stream.
+    tf_big::ChaChaStream::Key key;
+    OP_REQUIRES(ctx, tf_big::RandomKey(&key),
+                errors::Unavailable("could not read system randomness"));
+    ParallelFor(ctx, 2 * batch_size_, kPrimeSearchCost,
+                [&](int64 start, int64 limit) {
+                  for (int64 i = start; i < limit; i++) {
+                    tf_big::ChaChaStream stream(key, i);
+                    if (i % 2 == 0) {
+                      tf_big::RandomPrime(p_data[i / 2].get_mpz_t(), p_bits,
+                                          &stream);
+                    } else {
+                      tf_big::RandomPrime(q_data[i / 2].get_mpz_t(), q_bits,
+                                          &stream);
+                    }
+                  }
+                });
+
+    tf_big::ChaChaStream stream(key, 2 * batch_size_);
+    for (int i = 0; i < batch_size_; i++) {
+      while (p_data[i] == q_data[i]) {
+        tf_big::RandomPrime(q_data[i].get_mpz_t(), q_bits, &stream);
+      }
+      mpz_mul(n_data[i].get_mpz_t(), p_data[i].get_mpz_t(),
+              q_data[i].get_mpz_t());
+    }
 
-    TensorShape shape({1, 1});
+    TensorShape shape({batch_size_, 1});
     Tensor* p_res;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, shape, &p_res));
-    p_res->flat<Variant>()(0) = BigTensor(p_matrix);
+    p_res->flat<Variant>()(0) = BigTensor(std::move(p_matrix));
 
     Tensor* q_res;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(1, shape, &q_res));
-    q_res->flat<Variant>()(0) = BigTensor(q_matrix);
+    q_res->flat<Variant>()(0) = BigTensor(std::move(q_matrix));
 
     Tensor* n_res;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(2, shape, &n_res));
-    n_res->flat<Variant>()(0) = BigTensor(n_matrix);
-
-    mpz_clear(p);
-    mpz_clear(q);
-    mpz_clear(n);
+    n_res->flat<Variant>()(0) = BigTensor(std::move(n_matrix));
   }
+
+ private:
+  int batch_size_ = 1;
 };
 
 REGISTER_UNARY_VARIANT_DECODE_FUNCTION(BigTensor, BigTensor::kTypeName);
 
+// Reports the process-wide kernel counters, one row per op type that has run.
+class BigKernelCountersOp : public OpKernel {
+ public:
+  explicit BigKernelCountersOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    auto snapshot = tf_big::Counters::Read();
+    int64 n = snapshot.size();
+
+    Tensor* ops;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape{n}, &ops));
+    std::vector<Tensor*> values(4);
+    for (int k = 0; k < 4; k++) {
+      OP_REQUIRES_OK(ctx,
+                     ctx->allocate_output(k + 1, TensorShape{n}, &values[k]));
+    }
+
+    for (int64 i = 0; i < n; i++) {
+      ops->flat<tstring>()(i) = snapshot[i].op;
+      values[0]->flat<int64>()(i) = snapshot[i].calls;
+      values[1]->flat<int64>()(i) = snapshot[i].elements;
+      values[2]->flat<int64>()(i) = snapshot[i].limb_ops;
+      values[3]->flat<int64>()(i) = snapshot[i].wall_nanos;
+    }
+  }
+};
+
+// Reports the statistics of the pooled GMP allocator, see gmp_allocator.h.
+class BigGmpMemoryStatsOp : public OpKernel {
+ public:
+  explicit BigGmpMemoryStatsOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    auto stats = tf_big::ReadGmpMemoryStats();
+    int64 values[] = {stats.allocations, stats.pool_hits,
+                      stats.bytes_allocated, stats.bytes_in_use,
+                      stats.bytes_cached};
+    for (int k = 0; k < 5; k++) {
+      Tensor* out;
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(k, TensorShape{}, &out));
+      out->scalar<int64>()() = values[k];
+    }
+  }
+};
+
 REGISTER_KERNEL_BUILDER(
     Name("BigImport").Device(DEVICE_CPU).TypeConstraint<tstring>("dtype"),
-    BigImportOp<tstring>);
+    Instrumented<BigImportStringOp>);
 REGISTER_KERNEL_BUILDER(
     Name("BigImport").Device(DEVICE_CPU).TypeConstraint<int32>("dtype"),
-    BigImportOp<int32>);
+    Instrumented<BigImportIntegerOp<int32>>);
 REGISTER_KERNEL_BUILDER(
     Name("BigImport").Device(DEVICE_CPU).TypeConstraint<uint8>("dtype"),
-    BigImportOp<uint8>);
+    Instrumented<BigImportIntegerOp<uint8>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigImport").Device(DEVICE_CPU).TypeConstraint<int64>("dtype"),
+    Instrumented<BigImportIntegerOp<int64>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigImport").Device(DEVICE_CPU).TypeConstraint<uint64>("dtype"),
+    Instrumented<BigImportIntegerOp<uint64>>);
 
 REGISTER_KERNEL_BUILDER(
     Name("BigExport").Device(DEVICE_CPU).TypeConstraint<tstring>("dtype"),
-    BigExportOp<tstring>);
+    Instrumented<BigExportStringOp>);
 REGISTER_KERNEL_BUILDER(
     Name("BigExport").Device(DEVICE_CPU).TypeConstraint<int32>("dtype"),
-    BigExportOp<int32>);
+    Instrumented<BigExportIntegerOp<int32>>);
 REGISTER_KERNEL_BUILDER(
     Name("BigExport").Device(DEVICE_CPU).TypeConstraint<uint8>("dtype"),
-    BigExportOp<uint8>);
+    Instrumented<BigExportIntegerOp<uint8>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigExport").Device(DEVICE_CPU).TypeConstraint<int64>("dtype"),
+    Instrumented<BigExportIntegerOp<int64>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigExport").Device(DEVICE_CPU).TypeConstraint<uint64>("dtype"),
+    Instrumented<BigExportIntegerOp<uint64>>);
 
 REGISTER_KERNEL_BUILDER(
     Name("BigImportLimbs").Device(DEVICE_CPU).TypeConstraint<int32>("dtype"),
-    BigImportLimbsOp<int32>);
+    Instrumented<BigImportLimbsOp<int32>>);
 REGISTER_KERNEL_BUILDER(
     Name("BigImportLimbs").Device(DEVICE_CPU).TypeConstraint<uint8>("dtype"),
-    BigImportLimbsOp<uint8>);
+    Instrumented<BigImportLimbsOp<uint8>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigImportLimbs").Device(DEVICE_CPU).TypeConstraint<int64>("dtype"),
+    Instrumented<BigImportLimbsOp<int64>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigImportLimbs").Device(DEVICE_CPU).TypeConstraint<uint32>("dtype"),
+    Instrumented<BigImportLimbsOp<uint32>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigImportLimbs").Device(DEVICE_CPU).TypeConstraint<uint64>("dtype"),
+    Instrumented<BigImportLimbsOp<uint64>>);
 
 REGISTER_KERNEL_BUILDER(
     Name("BigExportLimbs").Device(DEVICE_CPU).TypeConstraint<int32>("dtype"),
-    BigExportLimbsOp<int32>);
+    Instrumented<BigExportLimbsOp<int32>>);
 REGISTER_KERNEL_BUILDER(
     Name("BigExportLimbs").Device(DEVICE_CPU).TypeConstraint<uint8>("dtype"),
-    BigExportLimbsOp<uint8>);
-
-// TODO(justin1121) there's no simple mpz to int64 convert functions
-// there's a suggestion here (https://stackoverflow.com/a/6248913/1116574) on
-// how to do it but it might take a bit of investigation from our side
-// perhaps arguable that we should only export/import to string for safety
-// can convert to number in python????
-// REGISTER_CPU(int64);
+    Instrumented<BigExportLimbsOp<uint8>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigExportLimbs").Device(DEVICE_CPU).TypeConstraint<int64>("dtype"),
+    Instrumented<BigExportLimbsOp<int64>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigExportLimbs").Device(DEVICE_CPU).TypeConstraint<uint32>("dtype"),
+    Instrumented<BigExportLimbsOp<uint32>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigExportLimbs").Device(DEVICE_CPU).TypeConstraint<uint64>("dtype"),
+    Instrumented<BigExportLimbsOp<uint64>>);
 
 REGISTER_KERNEL_BUILDER(Name("BigRandomUniform").Device(DEVICE_CPU),
-                        BigRandomUniformOp);
+                        Instrumented<BigRandomUniformOp>);
 REGISTER_KERNEL_BUILDER(Name("BigRandomRsaModulus").Device(DEVICE_CPU),
-                        BigRandomRsaModulusOp);
-
-REGISTER_KERNEL_BUILDER(Name("BigAdd").Device(DEVICE_CPU), BigAddOp);
-REGISTER_KERNEL_BUILDER(Name("BigSub").Device(DEVICE_CPU), BigSubOp);
-REGISTER_KERNEL_BUILDER(Name("BigMul").Device(DEVICE_CPU), BigMulOp);
-REGISTER_KERNEL_BUILDER(Name("BigDiv").Device(DEVICE_CPU), BigDivOp);
-REGISTER_KERNEL_BUILDER(Name("BigPow").Device(DEVICE_CPU), BigPowOp);
-REGISTER_KERNEL_BUILDER(Name("BigMatMul").Device(DEVICE_CPU), BigMatMulOp);
-REGISTER_KERNEL_BUILDER(Name("BigMod").Device(DEVICE_CPU), BigModOp);
-REGISTER_KERNEL_BUILDER(Name("BigInv").Device(DEVICE_CPU), BigInvOp);
+                        Instrumented<BigRandomRsaModulusOp>);
+
+REGISTER_KERNEL_BUILDER(Name("BigAdd").Device(DEVICE_CPU),
+                        Instrumented<BigAddOp>);
+REGISTER_KERNEL_BUILDER(Name("BigSub").Device(DEVICE_CPU),
+                        Instrumented<BigSubOp>);
+REGISTER_KERNEL_BUILDER(Name("BigMul").Device(DEVICE_CPU),
+                        Instrumented<BigMulOp>);
+REGISTER_KERNEL_BUILDER(Name("BigDiv").Device(DEVICE_CPU),
+                        Instrumented<BigDivOp>);
+REGISTER_KERNEL_BUILDER(Name("BigPow").Device(DEVICE_CPU),
+                        Instrumented<BigPowOp>);
+REGISTER_KERNEL_BUILDER(Name("BigPowCrt").Device(DEVICE_CPU),
+                        Instrumented<BigPowCrtOp>);
+REGISTER_KERNEL_BUILDER(Name("BigMatMul").Device(DEVICE_CPU),
+                        Instrumented<BigMatMulOp>);
+REGISTER_KERNEL_BUILDER(Name("BigMatMulMod").Device(DEVICE_CPU),
+                        Instrumented<BigMatMulModOp>);
+REGISTER_KERNEL_BUILDER(Name("BigMod").Device(DEVICE_CPU),
+                        Instrumented<BigModOp>);
+REGISTER_KERNEL_BUILDER(Name("BigInv").Device(DEVICE_CPU),
+                        Instrumented<BigInvOp>);
+REGISTER_KERNEL_BUILDER(Name("BigReduceSum").Device(DEVICE_CPU),
+                        Instrumented<BigReduceSumOp>);
+REGISTER_KERNEL_BUILDER(Name("BigReduceProdMod").Device(DEVICE_CPU),
+                        Instrumented<BigReduceProdModOp>);
+REGISTER_KERNEL_BUILDER(Name("BigSlice").Device(DEVICE_CPU),
+                        Instrumented<BigSliceOp>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigGather").Device(DEVICE_CPU).TypeConstraint<int32>("Tindices"),
+    Instrumented<BigGatherOp<int32>>);
+REGISTER_KERNEL_BUILDER(
+    Name("BigGather").Device(DEVICE_CPU).TypeConstraint<int64>("Tindices"),
+    Instrumented<BigGatherOp<int64>>);
+REGISTER_KERNEL_BUILDER(Name("BigConcat").Device(DEVICE_CPU),
+                        Instrumented<BigConcatOp>);
+REGISTER_KERNEL_BUILDER(Name("BigReshape").Device(DEVICE_CPU),
+                        Instrumented<BigReshapeOp>);
+REGISTER_KERNEL_BUILDER(Name("BigTranspose").Device(DEVICE_CPU),
+                        Instrumented<BigTransposeOp>);
+REGISTER_KERNEL_BUILDER(Name("BigMulMod").Device(DEVICE_CPU),
+                        Instrumented<BigModularBinaryOp<ModularMul>>);
+REGISTER_KERNEL_BUILDER(Name("BigAddMod").Device(DEVICE_CPU),
+                        Instrumented<BigModularBinaryOp<ModularAdd>>);
+REGISTER_KERNEL_BUILDER(Name("BigSubMod").Device(DEVICE_CPU),
+                        Instrumented<BigModularBinaryOp<ModularSub>>);
+
+REGISTER_KERNEL_BUILDER(Name("BigToMontgomery").Device(DEVICE_CPU),
+                        Instrumented<BigToMontgomeryOp>);
+REGISTER_KERNEL_BUILDER(Name("BigFromMontgomery").Device(DEVICE_CPU),
+                        Instrumented<BigFromMontgomeryOp>);
+REGISTER_KERNEL_BUILDER(Name("BigMontgomeryMul").Device(DEVICE_CPU),
+                        Instrumented<BigMontgomeryBinaryOp<MontgomeryMul>>);
+REGISTER_KERNEL_BUILDER(Name("BigMontgomeryAdd").Device(DEVICE_CPU),
+                        Instrumented<BigMontgomeryBinaryOp<MontgomeryAdd>>);
+REGISTER_KERNEL_BUILDER(Name("BigMontgomerySub").Device(DEVICE_CPU),
+                        Instrumented<BigMontgomeryBinaryOp<MontgomerySub>>);
+REGISTER_KERNEL_BUILDER(Name("BigMontgomeryPow").Device(DEVICE_CPU),
+                        Instrumented<BigMontgomeryPowOp>);
+
+REGISTER_KERNEL_BUILDER(Name("BigFixedBaseTable").Device(DEVICE_CPU),
+                        Instrumented<BigFixedBaseTableOp>);
+REGISTER_KERNEL_BUILDER(Name("BigPowFixedBase").Device(DEVICE_CPU),
+                        Instrumented<BigPowFixedBaseOp>);
+
+REGISTER_KERNEL_BUILDER(Name("BigObfuscatorPool").Device(DEVICE_CPU),
+                        Instrumented<BigObfuscatorPoolOp>);
+REGISTER_KERNEL_BUILDER(Name("BigObfuscatorPoolPop").Device(DEVICE_CPU),
+                        Instrumented<BigObfuscatorPoolPopOp>);
+
+REGISTER_KERNEL_BUILDER(Name("BigKernelCounters").Device(DEVICE_CPU),
+                        BigKernelCountersOp);
+REGISTER_KERNEL_BUILDER(Name("BigGmpMemoryStats").Device(DEVICE_CPU),
+                        BigGmpMemoryStatsOp);
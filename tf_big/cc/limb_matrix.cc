@@ -0,0 +1,96 @@
+#include "tf_big/cc/limb_matrix.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace tf_big {
+
+LimbMatrix::LimbMatrix(Eigen::Index rows, Eigen::Index cols, mp_size_t width)
+    : rows_(rows),
+      cols_(cols),
+      width_(width),
+      limbs_(rows * cols * width),
+      sizes_(rows * cols) {}
+
+void LimbMatrix::set(Eigen::Index i, mpz_srcptr x) {
+  mp_size_t n = mpz_size(x);
+  std::memcpy(limbs(i), mpz_limbs_read(x), n * sizeof(mp_limb_t));
+  std::fill(limbs(i) + n, limbs(i) + width_, 0);
+  sizes_[i] = mpz_sgn(x) < 0 ? -n : n;
+}
+
+mp_size_t LimbMatrix::max_size() const {
+  mp_size_t max_size = 0;
+  for (auto size : sizes_) {
+    max_size = std::max<mp_size_t>(max_size, std::labs(size));
+  }
+  return max_size;
+}
+
+namespace limb_ops {
+
+mp_size_t Normalize(const mp_limb_t* rp, mp_size_t n) {
+  while (n > 0 && rp[n - 1] == 0) {
+    n--;
+  }
+  return n;
+}
+
+mp_size_t Add(mp_limb_t* rp, const mp_limb_t* xp, mp_size_t xs,
+              const mp_limb_t* yp, mp_size_t ys) {
+  mp_size_t xn = std::labs(xs);
+  mp_size_t yn = std::labs(ys);
+  if (xn < yn) {
+    std::swap(xp, yp);
+    std::swap(xs, ys);
+    std::swap(xn, yn);
+  }
+
+  if (yn == 0) {
+    std::copy(xp, xp + xn, rp);
+    return xs;
+  }
+
+  if ((xs < 0) == (ys < 0)) {
+    rp[xn] = mpn_add(rp, xp, xn, yp, yn);
+    mp_size_t rn = xn + (rp[xn] != 0);
+    return xs < 0 ? -rn : rn;
+  }
+
+  // Signs differ: subtract the smaller magnitude from the larger one.
+  if (xn > yn || mpn_cmp(xp, yp, xn) >= 0) {
+    mpn_sub(rp, xp, xn, yp, yn);
+    mp_size_t rn = Normalize(rp, xn);
+    return xs < 0 ? -rn : rn;
+  }
+  mpn_sub_n(rp, yp, xp, xn);
+  mp_size_t rn = Normalize(rp, xn);
+  return ys < 0 ? -rn : rn;
+}
+
+mp_size_t Sub(mp_limb_t* rp, const mp_limb_t* xp, mp_size_t xs,
+              const mp_limb_t* yp, mp_size_t ys) {
+  return Add(rp, xp, xs, yp, -ys);
+}
+
+mp_size_t Mul(mp_limb_t* rp, const mp_limb_t* xp, mp_size_t xs,
+              const mp_limb_t* yp, mp_size_t ys) {
+  mp_size_t xn = std::labs(xs);
+  mp_size_t yn = std::labs(ys);
+  if (xn == 0 || yn == 0) {
+    return 0;
+  }
+  if (xn < yn) {
+    std::swap(xp, yp);
+    std::swap(xn, yn);
+  }
+
+  mpn_mul(rp, xp, xn, yp, yn);
+  mp_size_t rn = Normalize(rp, xn + yn);
+  return (xs < 0) != (ys < 0) ? -rn : rn;
+}
+
+}  // namespace limb_ops
+
+}  // namespace tf_big
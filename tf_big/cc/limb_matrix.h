@@ -0,0 +1,76 @@
+#ifndef TF_BIG_CC_LIMB_MATRIX_H_
+#define TF_BIG_CC_LIMB_MATRIX_H_
+
+#include <gmp.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Eigen/Core"
+
+namespace tf_big {
+
+// Matrix of big integers stored in one contiguous, aligned buffer of limbs.
+//
+// Every element gets `width` limbs holding its magnitude, least significant
+// limb first, with the signed number of limbs in use (as in mpz's `_mp_size`)
+// kept in a side array. Elements are laid out column-major to match MatrixXm,
+// so the same flat index addresses the same element in both representations.
+class LimbMatrix {
+ public:
+  LimbMatrix() : rows_(0), cols_(0), width_(0) {}
+  LimbMatrix(Eigen::Index rows, Eigen::Index cols, mp_size_t width);
+
+  Eigen::Index rows() const { return rows_; }
+  Eigen::Index cols() const { return cols_; }
+  Eigen::Index size() const { return rows_ * cols_; }
+  mp_size_t width() const { return width_; }
+
+  mp_limb_t* limbs(Eigen::Index i) { return limbs_.data() + i * width_; }
+  const mp_limb_t* limbs(Eigen::Index i) const {
+    return limbs_.data() + i * width_;
+  }
+
+  mp_size_t signed_size(Eigen::Index i) const { return sizes_[i]; }
+  void set_signed_size(Eigen::Index i, mp_size_t size) { sizes_[i] = size; }
+
+  // Returns a read-only mpz for element `i` backed by this matrix' limbs.
+  // `view` must outlive every use of the result but needs no initialization
+  // or clearing.
+  mpz_srcptr view(Eigen::Index i, mpz_ptr view) const {
+    return mpz_roinit_n(view, limbs(i), sizes_[i]);
+  }
+
+  // Copies `x` into element `i`; `x` must fit in `width` limbs.
+  void set(Eigen::Index i, mpz_srcptr x);
+
+  // Largest number of limbs used by any element.
+  mp_size_t max_size() const;
+
+ private:
+  Eigen::Index rows_;
+  Eigen::Index cols_;
+  mp_size_t width_;
+  std::vector<mp_limb_t, Eigen::aligned_allocator<mp_limb_t>> limbs_;
+  std::vector<int32_t> sizes_;
+};
+
+// Signed arithmetic directly on limb vectors. Operands are given as a limb
+// pointer and a signed size; the result is written to `rp` and its signed size
+// returned. `rp` must not overlap the operands and must have room for
+// max(|xs|, |ys|) + 1 limbs for Add and Sub, and |xs| + |ys| limbs for Mul.
+namespace limb_ops {
+// Strips high zero limbs and returns the resulting number of limbs.
+mp_size_t Normalize(const mp_limb_t* rp, mp_size_t n);
+
+mp_size_t Add(mp_limb_t* rp, const mp_limb_t* xp, mp_size_t xs,
+              const mp_limb_t* yp, mp_size_t ys);
+mp_size_t Sub(mp_limb_t* rp, const mp_limb_t* xp, mp_size_t xs,
+              const mp_limb_t* yp, mp_size_t ys);
+mp_size_t Mul(mp_limb_t* rp, const mp_limb_t* xp, mp_size_t xs,
+              const mp_limb_t* yp, mp_size_t ys);
+}  // namespace limb_ops
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_LIMB_MATRIX_H_
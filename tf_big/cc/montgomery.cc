@@ -0,0 +1,228 @@
+#include "tf_big/cc/montgomery.h"
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace tf_big {
+
+namespace {
+
+// Upper bound on the number of distinct moduli kept in the context cache; the
+// cache is simply flushed when it fills up since in practice a graph only
+// uses a handful of moduli.
+const size_t kMaxCachedContexts = 64;
+
+// Inverse of an odd limb modulo 2^GMP_NUMB_BITS by Newton iteration; each
+// step doubles the number of correct low bits, starting from three.
+mp_limb_t InverseLimb(mp_limb_t x) {
+  mp_limb_t inv = x;
+  for (int bits = 3; bits < GMP_NUMB_BITS; bits *= 2) {
+    inv *= 2 - x * inv;
+  }
+  return inv;
+}
+
+}  // namespace
+
+int PowWindowSize(size_t bits) {
+  if (bits > 671) return 6;
+  if (bits > 239) return 5;
+  if (bits > 79) return 4;
+  if (bits > 23) return 3;
+  if (bits > 6) return 2;
+  return 1;
+}
+
+MontgomeryContext::MontgomeryContext(mpz_srcptr modulus)
+    : MontgomeryContext(modulus, GetFixedWidthKernels(mpz_size(modulus))) {}
+
+MontgomeryContext::MontgomeryContext(mpz_srcptr modulus,
+                                     const FixedWidthKernels* fixed)
+    : fixed_(fixed) {
+  mpz_init_set(modulus_, modulus);
+  np_ = mpz_limbs_read(modulus_);
+  n_ = mpz_size(modulus_);
+  ninv_ = -InverseLimb(np_[0]);
+
+  mpz_t tmp;
+  mpz_init(tmp);
+
+  one_.resize(n_);
+  mpz_setbit(tmp, n_ * GMP_NUMB_BITS);
+  mpz_mod(tmp, tmp, modulus_);
+  std::copy(mpz_limbs_read(tmp), mpz_limbs_read(tmp) + mpz_size(tmp),
+            one_.begin());
+
+  r2_.resize(n_);
+  mpz_set_ui(tmp, 0);
+  mpz_setbit(tmp, 2 * n_ * GMP_NUMB_BITS);
+  mpz_mod(tmp, tmp, modulus_);
+  std::copy(mpz_limbs_read(tmp), mpz_limbs_read(tmp) + mpz_size(tmp),
+            r2_.begin());
+
+  mpz_clear(tmp);
+}
+
+MontgomeryContext::~MontgomeryContext() { mpz_clear(modulus_); }
+
+std::shared_ptr<const MontgomeryContext> MontgomeryContext::Get(
+    mpz_srcptr modulus) {
+  static std::mutex mu;
+  static std::unordered_map<std::string,
+                            std::shared_ptr<const MontgomeryContext>>
+      cache;
+
+  std::string key(reinterpret_cast<const char*>(mpz_limbs_read(modulus)),
+                  mpz_size(modulus) * sizeof(mp_limb_t));
+
+  std::lock_guard<std::mutex> lock(mu);
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    return it->second;
+  }
+  if (cache.size() >= kMaxCachedContexts) {
+    cache.clear();
+  }
+  std::shared_ptr<const MontgomeryContext> context(
+      new MontgomeryContext(modulus));
+  cache.emplace(std::move(key), context);
+  return context;
+}
+
+void MontgomeryContext::Load(mp_limb_t* rp, mpz_srcptr x, mpz_ptr tmp) const {
+  if (mpz_sgn(x) < 0 || mpz_cmp(x, modulus_) >= 0) {
+    mpz_mod(tmp, x, modulus_);
+    x = tmp;
+  }
+  mp_size_t size = mpz_size(x);
+  std::copy(mpz_limbs_read(x), mpz_limbs_read(x) + size, rp);
+  std::fill(rp + size, rp + n_, 0);
+}
+
+void MontgomeryContext::ToMontgomery(mp_limb_t* rp, mpz_srcptr x, mpz_ptr tmp,
+                                     mp_limb_t* tp) const {
+  Load(rp, x, tmp);
+  Mul(rp, rp, r2_.data(), tp);
+}
+
+void MontgomeryContext::FromMontgomery(mp_limb_t* rp, const mp_limb_t* ap,
+                                       mp_limb_t* tp) const {
+  std::copy(ap, ap + n_, tp);
+  std::fill(tp + n_, tp + 2 * n_, 0);
+  Redc(rp, tp);
+}
+
+void MontgomeryContext::Redc(mp_limb_t* rp, mp_limb_t* tp) const {
+  if (fixed_ != nullptr) {
+    fixed_->redc(rp, tp, np_, ninv_);
+    return;
+  }
+  // Clear one low limb per step; the limb that becomes zero is reused to hold
+  // the carry out of that step, and all carries are added in at the end.
+  mp_limb_t* up = tp;
+  for (mp_size_t i = 0; i < n_; i++) {
+    mp_limb_t q = up[0] * ninv_;
+    up[0] = mpn_addmul_1(up, np_, n_, q);
+    up++;
+  }
+  mp_limb_t carry = mpn_add_n(rp, up, tp, n_);
+  if (carry || mpn_cmp(rp, np_, n_) >= 0) {
+    mpn_sub_n(rp, rp, np_, n_);
+  }
+}
+
+void MontgomeryContext::Mul(mp_limb_t* rp, const mp_limb_t* ap,
+                            const mp_limb_t* bp, mp_limb_t* tp) const {
+  if (fixed_ != nullptr) {
+    fixed_->mul(rp, ap, bp, np_, ninv_);
+    return;
+  }
+  if (ap == bp) {
+    mpn_sqr(tp, ap, n_);
+  } else {
+    mpn_mul_n(tp, ap, bp, n_);
+  }
+  Redc(rp, tp);
+}
+
+void MontgomeryContext::Sqr(mp_limb_t* rp, const mp_limb_t* ap,
+                            mp_limb_t* tp) const {
+  if (fixed_ != nullptr) {
+    fixed_->sqr(rp, ap, np_, ninv_);
+    return;
+  }
+  mpn_sqr(tp, ap, n_);
+  Redc(rp, tp);
+}
+
+void MontgomeryContext::Add(mp_limb_t* rp, const mp_limb_t* ap,
+                            const mp_limb_t* bp) const {
+  if (fixed_ != nullptr) {
+    fixed_->add(rp, ap, bp, np_);
+    return;
+  }
+  mp_limb_t carry = mpn_add_n(rp, ap, bp, n_);
+  if (carry || mpn_cmp(rp, np_, n_) >= 0) {
+    mpn_sub_n(rp, rp, np_, n_);
+  }
+}
+
+void MontgomeryContext::Sub(mp_limb_t* rp, const mp_limb_t* ap,
+                            const mp_limb_t* bp) const {
+  if (fixed_ != nullptr) {
+    fixed_->sub(rp, ap, bp, np_);
+    return;
+  }
+  if (mpn_sub_n(rp, ap, bp, n_)) {
+    mpn_add_n(rp, rp, np_, n_);
+  }
+}
+
+void MontgomeryContext::Pow(mp_limb_t* rp, const mp_limb_t* ap, mpz_srcptr e,
+                            std::vector<mp_limb_t>* scratch) const {
+  size_t bits = mpz_sgn(e) == 0 ? 0 : mpz_sizeinbase(e, 2);
+  if (bits == 0) {
+    std::copy(one_.begin(), one_.end(), rp);
+    return;
+  }
+
+  int window = PowWindowSize(bits);
+  size_t table_size = size_t(1) << window;
+  scratch->resize((table_size + 3) * n_);
+  mp_limb_t* table = scratch->data();
+  mp_limb_t* acc = table + table_size * n_;
+  mp_limb_t* tp = acc + n_;
+
+  // table[k] = a^k
+  std::copy(one_.begin(), one_.end(), table);
+  std::copy(ap, ap + n_, table + n_);
+  for (size_t k = 2; k < table_size; k++) {
+    Mul(table + k * n_, table + (k - 1) * n_, ap, tp);
+  }
+
+  // Left-to-right over windows of the exponent, the top one possibly short.
+  size_t num_windows = (bits + window - 1) / window;
+  for (size_t w = num_windows; w-- > 0;) {
+    size_t digit = 0;
+    for (int b = window - 1; b >= 0; b--) {
+      digit = (digit << 1) | mpz_tstbit(e, w * window + b);
+    }
+
+    if (w == num_windows - 1) {
+      std::copy(table + digit * n_, table + (digit + 1) * n_, acc);
+      continue;
+    }
+    for (int b = 0; b < window; b++) {
+      Sqr(acc, acc, tp);
+    }
+    if (digit != 0) {
+      Mul(acc, acc, table + digit * n_, tp);
+    }
+  }
+
+  std::copy(acc, acc + n_, rp);
+}
+
+}  // namespace tf_big
@@ -0,0 +1,100 @@
+#ifndef TF_BIG_CC_MONTGOMERY_H_
+#define TF_BIG_CC_MONTGOMERY_H_
+
+#include <gmp.h>
+
+#include <memory>
+#include <vector>
+
+#include "tf_big/cc/fixed_width.h"
+
+namespace tf_big {
+
+// Window size for a fixed-window exponentiation with an exponent of the given
+// bit length, roughly balancing table setup against multiplications saved.
+int PowWindowSize(size_t bits);
+
+// Precomputed values for Montgomery arithmetic modulo an odd modulus N of n
+// limbs, with R = 2^(n * GMP_NUMB_BITS).
+//
+// Values in the Montgomery domain are residues aR mod N held as n-limb
+// vectors, least significant limb first, always fully reduced into [0, N).
+// Limb-level functions take such vectors; `tp` is caller-provided scratch
+// space of at least 2n limbs, and results may alias the operands.
+//
+// Moduli of a width with a FixedWidthKernels specialization run on those
+// kernels; all other widths use GMP's mpn functions.
+class MontgomeryContext {
+ public:
+  // `modulus` must be odd and greater than one.
+  explicit MontgomeryContext(mpz_srcptr modulus);
+  // As above, but running on `fixed`, which must be for the width of
+  // `modulus`, or on the mpn functions if nullptr. For testing.
+  MontgomeryContext(mpz_srcptr modulus, const FixedWidthKernels* fixed);
+  ~MontgomeryContext();
+
+  MontgomeryContext(const MontgomeryContext&) = delete;
+  MontgomeryContext& operator=(const MontgomeryContext&) = delete;
+
+  // Returns a context for `modulus`, reusing a previously computed one when
+  // the same modulus has been seen recently. Thread-safe.
+  static std::shared_ptr<const MontgomeryContext> Get(mpz_srcptr modulus);
+
+  // Number of limbs n in the modulus and in every domain value.
+  mp_size_t size() const { return n_; }
+
+  mpz_srcptr modulus() const { return modulus_; }
+
+  // R mod N, i.e. one in the Montgomery domain.
+  const mp_limb_t* one() const { return one_.data(); }
+
+  // rp = x mod N as an n-limb vector, without any conversion; `tmp` is an
+  // initialized mpz used when `x` needs reducing first.
+  void Load(mp_limb_t* rp, mpz_srcptr x, mpz_ptr tmp) const;
+
+  // rp = x R mod N.
+  void ToMontgomery(mp_limb_t* rp, mpz_srcptr x, mpz_ptr tmp,
+                    mp_limb_t* tp) const;
+
+  // rp = a R^-1 mod N.
+  void FromMontgomery(mp_limb_t* rp, const mp_limb_t* ap, mp_limb_t* tp) const;
+
+  // rp = a b R^-1 mod N.
+  void Mul(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp,
+           mp_limb_t* tp) const;
+
+  // rp = a^2 R^-1 mod N.
+  void Sqr(mp_limb_t* rp, const mp_limb_t* ap, mp_limb_t* tp) const;
+
+  // rp = a + b mod N.
+  void Add(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp) const;
+
+  // rp = a - b mod N.
+  void Sub(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp) const;
+
+  // rp = a^e in the Montgomery domain for a non-negative exponent `e`, using
+  // a fixed window sized from the exponent. `scratch` is resized as needed and
+  // can be reused across calls to avoid allocations.
+  void Pow(mp_limb_t* rp, const mp_limb_t* ap, mpz_srcptr e,
+           std::vector<mp_limb_t>* scratch) const;
+
+  // Montgomery reduction: rp = t R^-1 mod N for a 2n-limb t < N R. The
+  // contents of `tp` are destroyed.
+  void Redc(mp_limb_t* rp, mp_limb_t* tp) const;
+
+ private:
+  mpz_t modulus_;
+  const mp_limb_t* np_;
+  mp_size_t n_;
+  // -N^-1 mod 2^GMP_NUMB_BITS
+  mp_limb_t ninv_;
+  std::vector<mp_limb_t> one_;
+  // R^2 mod N
+  std::vector<mp_limb_t> r2_;
+  // Kernels specialized for n limbs, or nullptr.
+  const FixedWidthKernels* fixed_;
+};
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_MONTGOMERY_H_
@@ -0,0 +1,146 @@
+#include "tf_big/cc/montgomery.h"
+
+#include <gmpxx.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace tf_big {
+namespace {
+
+std::vector<mp_limb_t> ToLimbs(const mpz_class& x, mp_size_t n) {
+  std::vector<mp_limb_t> limbs(n, 0);
+  mpz_export(limbs.data(), nullptr, -1, sizeof(mp_limb_t), 0, 0,
+             x.get_mpz_t());
+  return limbs;
+}
+
+mpz_class FromLimbs(const mp_limb_t* limbs, mp_size_t n) {
+  mpz_class x;
+  mpz_import(x.get_mpz_t(), n, -1, sizeof(mp_limb_t), 0, 0, limbs);
+  return x;
+}
+
+// Runs MontgomeryContext for moduli of GetParam() limbs on every kernel it
+// can use at that width: the fixed-width kernels, if there are any, and the
+// mpn functions used for other widths or with TF_BIG_FIXED_WIDTH=0.
+class MontgomeryContextTest : public ::testing::TestWithParam<int> {
+ protected:
+  MontgomeryContextTest() : n_(GetParam()), random_(gmp_randinit_default) {
+    random_.seed(n_);
+    kernels_.push_back(nullptr);
+    if (GetFixedWidthKernels(n_) != nullptr) {
+      kernels_.push_back(GetFixedWidthKernels(n_));
+    }
+  }
+
+  // Odd moduli of exactly n limbs: random ones, and ones with the top limb
+  // all ones or (past one limb) just one, where carries and final
+  // subtractions are likeliest to go wrong.
+  std::vector<mpz_class> Moduli() {
+    std::vector<mpz_class> moduli;
+    mpz_class top = mpz_class(1) << (GMP_NUMB_BITS * (n_ - 1));
+    for (int i = 0; i < 10; i++) {
+      mpz_class n = random_.get_z_bits(GMP_NUMB_BITS * n_) | 1;
+      mpz_setbit(n.get_mpz_t(), GMP_NUMB_BITS * n_ - 1);
+      moduli.push_back(n);
+    }
+    moduli.push_back((top << GMP_NUMB_BITS) - 1);
+    moduli.push_back((top << GMP_NUMB_BITS) - 59);
+    if (n_ > 1) {
+      moduli.push_back(top + 1);
+      moduli.push_back((top + random_.get_z_bits(GMP_NUMB_BITS * (n_ - 1))) |
+                       1);
+    }
+    return moduli;
+  }
+
+  // Operands below `modulus`, including the extremes.
+  std::vector<mpz_class> Values(const mpz_class& modulus) {
+    std::vector<mpz_class> values = {0, 1, modulus - 1, modulus - 2};
+    for (int i = 0; i < 6; i++) {
+      values.push_back(random_.get_z_range(modulus));
+    }
+    return values;
+  }
+
+  mp_size_t n_;
+  gmp_randclass random_;
+  std::vector<const FixedWidthKernels*> kernels_;
+};
+
+TEST_P(MontgomeryContextTest, MatchesGmp) {
+  for (const FixedWidthKernels* fixed : kernels_) {
+    SCOPED_TRACE(fixed == nullptr ? "mpn" : "fixed width");
+    for (const mpz_class& modulus : Moduli()) {
+      SCOPED_TRACE(modulus.get_str(16));
+      MontgomeryContext context(modulus.get_mpz_t(), fixed);
+      mpz_class r = mpz_class(1) << (GMP_NUMB_BITS * n_);
+      mpz_class r_inv;
+      mpz_invert(r_inv.get_mpz_t(), r.get_mpz_t(), modulus.get_mpz_t());
+
+      mpz_class tmp;
+      std::vector<mp_limb_t> tp(2 * n_);
+      std::vector<mp_limb_t> scratch;
+      std::vector<mpz_class> values = Values(modulus);
+      for (const mpz_class& a : values) {
+        for (const mpz_class& b : values) {
+          std::vector<mp_limb_t> ap = ToLimbs(a, n_);
+          std::vector<mp_limb_t> bp = ToLimbs(b, n_);
+          std::vector<mp_limb_t> rp(n_);
+
+          context.Mul(rp.data(), ap.data(), bp.data(), tp.data());
+          EXPECT_EQ(FromLimbs(rp.data(), n_), a * b * r_inv % modulus);
+          context.Add(rp.data(), ap.data(), bp.data());
+          EXPECT_EQ(FromLimbs(rp.data(), n_), (a + b) % modulus);
+          context.Sub(rp.data(), ap.data(), bp.data());
+          EXPECT_EQ(FromLimbs(rp.data(), n_), (a - b + modulus) % modulus);
+
+          // Results written over the second operand.
+          std::vector<mp_limb_t> alias = bp;
+          context.Mul(alias.data(), ap.data(), alias.data(), tp.data());
+          EXPECT_EQ(FromLimbs(alias.data(), n_), a * b * r_inv % modulus);
+          alias = bp;
+          context.Sub(alias.data(), ap.data(), alias.data());
+          EXPECT_EQ(FromLimbs(alias.data(), n_), (a - b + modulus) % modulus);
+        }
+
+        std::vector<mp_limb_t> ap = ToLimbs(a, n_);
+        std::vector<mp_limb_t> rp(n_);
+        context.Sqr(rp.data(), ap.data(), tp.data());
+        EXPECT_EQ(FromLimbs(rp.data(), n_), a * a * r_inv % modulus);
+        context.Mul(rp.data(), ap.data(), ap.data(), tp.data());
+        EXPECT_EQ(FromLimbs(rp.data(), n_), a * a * r_inv % modulus);
+
+        // Conversions and exponentiation, all in place.
+        context.ToMontgomery(ap.data(), a.get_mpz_t(), tmp.get_mpz_t(),
+                             tp.data());
+        EXPECT_EQ(FromLimbs(ap.data(), n_), a * r % modulus);
+        for (unsigned long e : {0ul, 1ul, 2ul, 3ul, 65537ul}) {
+          mpz_class exponent = e;
+          std::vector<mp_limb_t> pp(n_);
+          context.Pow(pp.data(), ap.data(), exponent.get_mpz_t(), &scratch);
+          context.FromMontgomery(pp.data(), pp.data(), tp.data());
+          mpz_class expected;
+          mpz_powm_ui(expected.get_mpz_t(), a.get_mpz_t(), e,
+                      modulus.get_mpz_t());
+          EXPECT_EQ(FromLimbs(pp.data(), n_), expected) << "e = " << e;
+        }
+        mpz_class exponent = random_.get_z_bits(300);
+        context.Pow(ap.data(), ap.data(), exponent.get_mpz_t(), &scratch);
+        context.FromMontgomery(ap.data(), ap.data(), tp.data());
+        mpz_class expected;
+        mpz_powm(expected.get_mpz_t(), a.get_mpz_t(), exponent.get_mpz_t(),
+                 modulus.get_mpz_t());
+        EXPECT_EQ(FromLimbs(ap.data(), n_), expected);
+      }
+    }
+  }
+}
+
+// Every fixed-width specialization, plus the widths on either side of them.
+INSTANTIATE_TEST_CASE_P(Widths, MontgomeryContextTest, ::testing::Range(1, 10));
+
+}  // namespace
+}  // namespace tf_big
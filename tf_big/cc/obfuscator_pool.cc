@@ -0,0 +1,89 @@
+#include "tf_big/cc/obfuscator_pool.h"
+
+#include <algorithm>
+
+namespace tf_big {
+
+ObfuscatorPool::ObfuscatorPool(mpz_srcptr n, size_t capacity,
+                               const ChaChaStream::Key& key)
+    : capacity_(capacity), low_water_((capacity + 1) / 2) {
+  mpz_init_set(n_, n);
+  mpz_init(n_squared_);
+  mpz_mul(n_squared_, n_, n_);
+  width_ = mpz_size(n_squared_);
+  buffer_.resize(capacity_ * width_);
+
+  producer_.reset(tensorflow::Env::Default()->StartThread(
+      tensorflow::ThreadOptions(), "tf_big_obfuscator_pool",
+      [this, key] { Run(key); }));
+}
+
+ObfuscatorPool::~ObfuscatorPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopped_ = true;
+  }
+  below_low_water_.notify_all();
+  producer_.reset();
+
+  mpz_clear(n_);
+  mpz_clear(n_squared_);
+}
+
+size_t ObfuscatorPool::Pop(mp_limb_t* rp, size_t count) {
+  std::lock_guard<std::mutex> lock(mu_);
+  count = std::min(count, count_);
+  for (size_t i = 0; i < count; i++) {
+    const mp_limb_t* slot = buffer_.data() + head_ * width_;
+    rp = std::copy(slot, slot + width_, rp);
+    head_ = (head_ + 1) % capacity_;
+  }
+  bool wake = count_ >= low_water_ && count_ - count < low_water_;
+  count_ -= count;
+  if (wake) {
+    below_low_water_.notify_one();
+  }
+  return count;
+}
+
+void ObfuscatorPool::Compute(mp_limb_t* rp, ChaChaStream* stream) const {
+  mp_size_t n = mpz_size(n_);
+  std::vector<mp_limb_t> r(n);
+  do {
+    RandomBelow(r.data(), mpz_limbs_read(n_), n, stream);
+  } while (mpn_zero_p(r.data(), n));
+
+  mpz_t r_view, res;
+  mpz_init(res);
+  mpz_powm(res, mpz_roinit_n(r_view, r.data(), n), n_, n_squared_);
+  mp_size_t size = mpz_size(res);
+  std::copy(mpz_limbs_read(res), mpz_limbs_read(res) + size, rp);
+  std::fill(rp + size, rp + width_, 0);
+  mpz_clear(res);
+}
+
+void ObfuscatorPool::Run(ChaChaStream::Key key) {
+  ChaChaStream stream(key, 0);
+  std::vector<mp_limb_t> value(width_);
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      if (count_ == capacity_) {
+        below_low_water_.wait(
+            lock, [this] { return stopped_ || count_ < low_water_; });
+      }
+      if (stopped_) {
+        return;
+      }
+    }
+
+    Compute(value.data(), &stream);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    auto slot = buffer_.data() + (head_ + count_) % capacity_ * width_;
+    std::copy(value.begin(), value.end(), slot);
+    count_++;
+  }
+}
+
+}  // namespace tf_big
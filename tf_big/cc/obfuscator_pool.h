@@ -0,0 +1,78 @@
+#ifndef TF_BIG_CC_OBFUSCATOR_POOL_H_
+#define TF_BIG_CC_OBFUSCATOR_POOL_H_
+
+#include <gmp.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tf_big/cc/random.h"
+
+namespace tf_big {
+
+// Bounded pool of Paillier obfuscators r^n mod n^2 for random r in Z_n,
+// filled by a background thread so that encryption does not have to pay for
+// the exponentiation on its critical path.
+//
+// Obfuscators are held as vectors of `width()` limbs, the size of n^2,
+// least significant limb first. Once the pool is full the producer sleeps
+// until consumers have drained it below half its capacity, and then refills
+// it in one go.
+class ObfuscatorPool {
+ public:
+  // Starts a producer thread for modulus `n`, which must be odd and greater
+  // than one, keeping up to `capacity` obfuscators ready. `key` seeds the
+  // producer's random stream.
+  ObfuscatorPool(mpz_srcptr n, size_t capacity, const ChaChaStream::Key& key);
+  // Stops and joins the producer thread.
+  ~ObfuscatorPool();
+
+  ObfuscatorPool(const ObfuscatorPool&) = delete;
+  ObfuscatorPool& operator=(const ObfuscatorPool&) = delete;
+
+  mpz_srcptr modulus() const { return n_; }
+  mp_size_t width() const { return width_; }
+  size_t capacity() const { return capacity_; }
+
+  // Moves up to `count` obfuscators into consecutive `width()`-limb slots
+  // starting at `rp` and returns how many were available.
+  size_t Pop(mp_limb_t* rp, size_t count);
+
+  // Computes a fresh obfuscator into the `width()`-limb vector `rp`, drawing
+  // r from `stream`; used by the producer, and by consumers when the pool
+  // runs dry.
+  void Compute(mp_limb_t* rp, ChaChaStream* stream) const;
+
+  // Approximate memory held by the pool, in bytes.
+  size_t MemoryUsed() const { return buffer_.size() * sizeof(mp_limb_t); }
+
+ private:
+  void Run(ChaChaStream::Key key);
+
+  mpz_t n_;
+  mpz_t n_squared_;
+  mp_size_t width_;
+  size_t capacity_;
+
+  // The producer is woken when `count_` drops below this.
+  size_t low_water_;
+
+  std::mutex mu_;
+  std::condition_variable below_low_water_;
+  // Ring buffer of `capacity_` slots of which `count_` starting at `head_`
+  // are in use.
+  std::vector<mp_limb_t> buffer_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  bool stopped_ = false;
+
+  // Deleting the thread joins it.
+  std::unique_ptr<tensorflow::Thread> producer_;
+};
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_OBFUSCATOR_POOL_H_
@@ -3,7 +3,9 @@
 #include "tensorflow/core/framework/shape_inference.h"
 
 REGISTER_OP("BigImport")
-    .Attr("dtype: {int32, string, uint8}")
+    .Attr("dtype: {int32, string, uint8, int64, uint64}")
+    .Attr("storage: {'mpz', 'limbs'} = 'mpz'")
+    .Attr("string_format: {'decimal', 'hex', 'bytes'} = 'decimal'")
     .Input("in: dtype")
     .Output("val: variant")
     .SetIsStateful()
@@ -15,7 +17,9 @@ REGISTER_OP("BigImport")
     });
 
 REGISTER_OP("BigImportLimbs")
-    .Attr("dtype: {uint8, int32}")
+    .Attr("dtype: {uint8, int32, int64, uint32, uint64}")
+    .Attr("storage: {'mpz', 'limbs'} = 'mpz'")
+    .Attr("layout: {'header', 'fixed'} = 'header'")
     .Input("in: dtype")
     .Output("val: variant")
     .SetIsStateful()
@@ -31,14 +35,17 @@ REGISTER_OP("BigImportLimbs")
     });
 
 REGISTER_OP("BigExport")
-    .Attr("dtype: {int32, string, uint8}")
+    .Attr("dtype: {int32, string, uint8, int64, uint64}")
+    .Attr("checked: bool = false")
+    .Attr("string_format: {'decimal', 'hex', 'bytes'} = 'decimal'")
     .Input("val: variant")
     .Output("out: dtype")
     .SetIsStateful()
     .SetShapeFn(::tensorflow::shape_inference::UnchangedShape);
 
 REGISTER_OP("BigExportLimbs")
-    .Attr("dtype: {int32, uint8}")
+    .Attr("dtype: {int32, uint8, int64, uint32, uint64}")
+    .Attr("layout: {'header', 'fixed'} = 'header'")
     .Input("val: variant")
     .Input("max_bitlen: int32")
     .Output("out: dtype")
@@ -61,6 +68,8 @@ REGISTER_OP("BigExportLimbs")
     });
 
 REGISTER_OP("BigRandomUniform")
+    .Attr("seed: list(int) = []")
+    .Attr("stream: int = 0")
     .Input("shape: int32")
     .Input("maxval: variant")
     .Output("out: variant")
@@ -74,6 +83,7 @@ REGISTER_OP("BigRandomUniform")
     });
 
 REGISTER_OP("BigRandomRsaModulus")
+    .Attr("batch_size: int >= 1 = 1")
     .Input("bitlength: int32")
     .Output("p: variant")
     .Output("q: variant")
@@ -81,12 +91,14 @@ REGISTER_OP("BigRandomRsaModulus")
     .SetIsStateful()
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
       ::tensorflow::shape_inference::ShapeHandle bitlength_shape = c->input(0);
-      ::tensorflow::shape_inference::ShapeHandle scalar_shape =
-          c->MakeShape({1, 1});
+      ::tensorflow::int64 batch_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("batch_size", &batch_size));
+      ::tensorflow::shape_inference::ShapeHandle batch_shape =
+          c->Matrix(batch_size, 1);
       TF_RETURN_IF_ERROR(c->WithRank(bitlength_shape, 0, &bitlength_shape));
-      c->set_output(0, scalar_shape);
-      c->set_output(1, scalar_shape);
-      c->set_output(2, scalar_shape);
+      c->set_output(0, batch_shape);
+      c->set_output(1, batch_shape);
+      c->set_output(2, batch_shape);
       return ::tensorflow::Status::OK();
     });
 
@@ -96,12 +108,8 @@ REGISTER_OP("BigAdd")
     .Output("res: variant")
     .SetIsStateful()
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
-      ::tensorflow::shape_inference::ShapeHandle val0 = c->input(0);
-      ::tensorflow::shape_inference::ShapeHandle val1 = c->input(1);
-      ::tensorflow::shape_inference::ShapeHandle res;
-      TF_RETURN_IF_ERROR(c->Merge(val0, val1, &res));
-      c->set_output(0, res);
-      return ::tensorflow::Status::OK();
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
     });
 
 REGISTER_OP("BigSub")
@@ -110,12 +118,8 @@ REGISTER_OP("BigSub")
     .Output("res: variant")
     .SetIsStateful()
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
-      ::tensorflow::shape_inference::ShapeHandle val0 = c->input(0);
-      ::tensorflow::shape_inference::ShapeHandle val1 = c->input(1);
-      ::tensorflow::shape_inference::ShapeHandle res;
-      TF_RETURN_IF_ERROR(c->Merge(val0, val1, &res));
-      c->set_output(0, res);
-      return ::tensorflow::Status::OK();
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
     });
 
 REGISTER_OP("BigMul")
@@ -126,15 +130,13 @@ REGISTER_OP("BigMul")
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
       ::tensorflow::shape_inference::ShapeHandle val0 = c->input(0);
       ::tensorflow::shape_inference::ShapeHandle val1 = c->input(1);
-      ::tensorflow::shape_inference::ShapeHandle res;
       // NOTE: Bug - without this condition returns shape of [1,1,1,1]
       if ((c->Rank(val0) == 0) & (c->Rank(val1) == 0)) {
         c->set_output(0, c->MakeShape({1, 1}));
-      } else {
-        TF_RETURN_IF_ERROR(c->Merge(val0, val1, &res));
-        c->set_output(0, res);
+        return ::tensorflow::Status::OK();
       }
-      return ::tensorflow::Status::OK();
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
     });
 
 REGISTER_OP("BigDiv")
@@ -143,13 +145,8 @@ REGISTER_OP("BigDiv")
     .Output("res: variant")
     .SetIsStateful()
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
-      ::tensorflow::shape_inference::ShapeHandle val0 = c->input(0);
-      ::tensorflow::shape_inference::ShapeHandle val1 = c->input(1);
-      ::tensorflow::shape_inference::ShapeHandle res;
-
-      TF_RETURN_IF_ERROR(c->Merge(val0, val1, &res));
-      c->set_output(0, res);
-      return ::tensorflow::Status::OK();
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
     });
 
 REGISTER_OP("BigPow")
@@ -160,21 +157,56 @@ REGISTER_OP("BigPow")
     .Output("res: variant")
     .SetIsStateful()
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
-      ::tensorflow::shape_inference::ShapeHandle base = c->input(0);
-      // ::tensorflow::shape_inference::ShapeHandle exponent = c->input(1);
-      // ::tensorflow::shape_inference::ShapeHandle modulus = c->input(2);
-      // ::tensorflow::shape_inference::ShapeHandle res;
-      // TODO(Morten) make sure shapes match
-      c->set_output(0, base);
-      return ::tensorflow::Status::OK();
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigPowCrt")
+    .Attr("secure: bool")
+    .Attr("squared: bool = false")
+    .Input("base: variant")
+    .Input("exponent: variant")
+    .Input("p: variant")
+    .Input("q: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
     });
 
-// TODO(Morten) add shape inference function
 REGISTER_OP("BigMatMul")
     .Input("val0: variant")
     .Input("val1: variant")
     .Output("res: variant")
-    .SetIsStateful();
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val0;
+      ::tensorflow::shape_inference::ShapeHandle val1;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &val0));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &val1));
+      ::tensorflow::shape_inference::DimensionHandle inner;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(val0, 1), c->Dim(val1, 0), &inner));
+      c->set_output(0, c->Matrix(c->Dim(val0, 0), c->Dim(val1, 1)));
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigMatMulMod")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val0;
+      ::tensorflow::shape_inference::ShapeHandle val1;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &val0));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &val1));
+      ::tensorflow::shape_inference::DimensionHandle inner;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(val0, 1), c->Dim(val1, 0), &inner));
+      c->set_output(0, c->Matrix(c->Dim(val0, 0), c->Dim(val1, 1)));
+      return ::tensorflow::Status::OK();
+    });
 
 REGISTER_OP("BigMod")
     .Input("val: variant")
@@ -192,6 +224,7 @@ REGISTER_OP("BigMod")
     });
 
 REGISTER_OP("BigInv")
+    .Attr("batched: bool = false")
     .Input("val: variant")
     .Input("mod: variant")
     .Output("res: variant")
@@ -205,3 +238,323 @@ REGISTER_OP("BigInv")
       c->set_output(0, val);
       return ::tensorflow::Status::OK();
     });
+
+namespace {
+
+// Reductions keep the reduced dimension with size one, so that the result is
+// still a matrix.
+::tensorflow::Status ReduceShape(
+    ::tensorflow::shape_inference::InferenceContext* c) {
+  ::tensorflow::shape_inference::ShapeHandle val;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &val));
+  bool reduce_all;
+  TF_RETURN_IF_ERROR(c->GetAttr("reduce_all", &reduce_all));
+  ::tensorflow::int64 axis;
+  TF_RETURN_IF_ERROR(c->GetAttr("axis", &axis));
+  if (reduce_all) {
+    c->set_output(0, c->Matrix(1, 1));
+  } else if (axis == 0) {
+    c->set_output(0, c->Matrix(1, c->Dim(val, 1)));
+  } else if (axis == 1) {
+    c->set_output(0, c->Matrix(c->Dim(val, 0), 1));
+  } else {
+    return ::tensorflow::errors::InvalidArgument("axis must be 0 or 1, got ",
+                                                 axis);
+  }
+  return ::tensorflow::Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("BigReduceSum")
+    .Attr("reduce_all: bool = false")
+    .Attr("axis: int = 0")
+    .Input("val: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn(ReduceShape);
+
+REGISTER_OP("BigReduceProdMod")
+    .Attr("reduce_all: bool = false")
+    .Attr("axis: int = 0")
+    .Input("val: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn(ReduceShape);
+
+REGISTER_OP("BigSlice")
+    .Input("val: variant")
+    .Input("begin: int32")
+    .Input("size: int32")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &val));
+      // Sizes of -1 depend on `begin` and are left unknown.
+      ::tensorflow::shape_inference::ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromShapeTensor(2, &out));
+      TF_RETURN_IF_ERROR(c->WithRank(out, 2, &out));
+      c->set_output(0, out);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigGather")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("axis: int = 0")
+    .Input("val: variant")
+    .Input("indices: Tindices")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &val));
+      ::tensorflow::shape_inference::ShapeHandle indices;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &indices));
+      ::tensorflow::int64 axis;
+      TF_RETURN_IF_ERROR(c->GetAttr("axis", &axis));
+      if (axis != 0 && axis != 1) {
+        return ::tensorflow::errors::InvalidArgument(
+            "axis must be 0 or 1, got ", axis);
+      }
+      ::tensorflow::shape_inference::ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(val, axis, c->Dim(indices, 0), &out));
+      c->set_output(0, out);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigConcat")
+    .Attr("N: int >= 1")
+    .Attr("axis: int = 0")
+    .Input("values: N * variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::int64 axis;
+      TF_RETURN_IF_ERROR(c->GetAttr("axis", &axis));
+      if (axis != 0 && axis != 1) {
+        return ::tensorflow::errors::InvalidArgument(
+            "axis must be 0 or 1, got ", axis);
+      }
+      ::tensorflow::shape_inference::ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &out));
+      for (int i = 1; i < c->num_inputs(); i++) {
+        ::tensorflow::shape_inference::ShapeHandle val;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 2, &val));
+        ::tensorflow::shape_inference::DimensionHandle across;
+        TF_RETURN_IF_ERROR(
+            c->Merge(c->Dim(out, 1 - axis), c->Dim(val, 1 - axis), &across));
+        ::tensorflow::shape_inference::DimensionHandle along;
+        TF_RETURN_IF_ERROR(
+            c->Add(c->Dim(out, axis), c->Dim(val, axis), &along));
+        TF_RETURN_IF_ERROR(c->ReplaceDim(out, axis, along, &out));
+        TF_RETURN_IF_ERROR(c->ReplaceDim(out, 1 - axis, across, &out));
+      }
+      c->set_output(0, out);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigReshape")
+    .Input("val: variant")
+    .Input("shape: int32")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromShapeTensor(1, &out));
+      TF_RETURN_IF_ERROR(c->WithRank(out, 2, &out));
+      c->set_output(0, out);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigTranspose")
+    .Input("val: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &val));
+      c->set_output(0, c->Matrix(c->Dim(val, 1), c->Dim(val, 0)));
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigMulMod")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigAddMod")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigSubMod")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigToMontgomery")
+    .Input("val: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val = c->input(0);
+      ::tensorflow::shape_inference::ShapeHandle mod = c->input(1);
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(val, 2, &val));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(mod, 2, &mod));
+      c->set_output(0, val);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigFromMontgomery")
+    .Input("val: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle val = c->input(0);
+      ::tensorflow::shape_inference::ShapeHandle mod = c->input(1);
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(val, 2, &val));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(mod, 2, &mod));
+      c->set_output(0, val);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigMontgomeryMul")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigMontgomeryAdd")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigMontgomerySub")
+    .Input("val0: variant")
+    .Input("val1: variant")
+    .Input("mod: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigMontgomeryPow")
+    .Input("base: variant")
+    .Input("exponent: variant")
+    .Input("modulus: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      return ::tensorflow::shape_inference::BroadcastBinaryOpOutputShapeFn(
+          c, 0);
+    });
+
+REGISTER_OP("BigFixedBaseTable")
+    .Attr("window: int = 4")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Input("base: variant")
+    .Input("modulus: variant")
+    .Input("max_bitlen: int32")
+    .Output("table: resource")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle max_bitlen_shape = c->input(2);
+      TF_RETURN_IF_ERROR(c->WithRank(max_bitlen_shape, 0, &max_bitlen_shape));
+      c->set_output(0, c->Scalar());
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigPowFixedBase")
+    .Input("table: resource")
+    .Input("exponent: variant")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      c->set_output(0, c->input(1));
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigObfuscatorPool")
+    .Attr("capacity: int >= 1 = 1024")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Input("modulus: variant")
+    .Output("pool: resource")
+    .SetIsStateful()
+    .SetShapeFn(::tensorflow::shape_inference::ScalarShape);
+
+REGISTER_OP("BigObfuscatorPoolPop")
+    .Input("pool: resource")
+    .Input("shape: int32")
+    .Output("res: variant")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      ::tensorflow::shape_inference::ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromShapeTensor(1, &out));
+      c->set_output(0, out);
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigKernelCounters")
+    .Output("op: string")
+    .Output("calls: int64")
+    .Output("elements: int64")
+    .Output("limb_ops: int64")
+    .Output("wall_nanos: int64")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      for (int i = 0; i < 5; i++) {
+        c->set_output(i, c->Vector(c->UnknownDim()));
+      }
+      return ::tensorflow::Status::OK();
+    });
+
+REGISTER_OP("BigGmpMemoryStats")
+    .Output("allocations: int64")
+    .Output("pool_hits: int64")
+    .Output("bytes_allocated: int64")
+    .Output("bytes_in_use: int64")
+    .Output("bytes_cached: int64")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      for (int i = 0; i < 5; i++) {
+        c->set_output(i, c->Scalar());
+      }
+      return ::tensorflow::Status::OK();
+    });
@@ -0,0 +1,81 @@
+#include "tf_big/cc/primes.h"
+
+#include <vector>
+
+namespace tf_big {
+
+namespace {
+
+// Candidates are trial divided by the odd primes below this bound.
+const unsigned long kSieveLimit = 1 << 15;
+
+// Miller-Rabin rounds on top of the Baillie-PSW test done by GMP.
+const int kPrimalityReps = 25;
+
+// Odd primes below kSieveLimit.
+const std::vector<unsigned long>& SmallPrimes() {
+  static const std::vector<unsigned long>* primes = [] {
+    std::vector<bool> composite(kSieveLimit);
+    auto res = new std::vector<unsigned long>();
+    for (unsigned long i = 3; i < kSieveLimit; i += 2) {
+      if (composite[i]) {
+        continue;
+      }
+      res->push_back(i);
+      for (unsigned long j = i * i; j < kSieveLimit; j += 2 * i) {
+        composite[j] = true;
+      }
+    }
+    return res;
+  }();
+  return *primes;
+}
+
+}  // namespace
+
+void RandomPrime(mpz_ptr p, size_t bits, ChaChaStream* stream) {
+  static_assert(GMP_NUMB_BITS == 64, "limbs are filled 64 bits at a time");
+  const auto& primes = SmallPrimes();
+
+  // Only divide by primes below the smallest candidate, or a candidate that
+  // is itself one of them would be rejected.
+  size_t num_primes = primes.size();
+  if (bits <= 16) {
+    num_primes = 0;
+    while (num_primes < primes.size() &&
+           primes[num_primes] < (1ul << (bits - 1))) {
+      num_primes++;
+    }
+  }
+
+  mp_size_t n = (bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+  int top_bits = bits - (n - 1) * GMP_NUMB_BITS;
+  mp_limb_t top_mask = top_bits == GMP_NUMB_BITS
+                           ? ~mp_limb_t(0)
+                           : (mp_limb_t(1) << top_bits) - 1;
+
+  for (;;) {
+    mp_limb_t* rp = mpz_limbs_write(p, n);
+    for (mp_size_t i = 0; i < n; i++) {
+      rp[i] = stream->Next();
+    }
+    rp[n - 1] &= top_mask;
+    mpz_limbs_finish(p, n);
+    mpz_setbit(p, bits - 1);
+    mpz_setbit(p, bits - 2);
+    mpz_setbit(p, 0);
+
+    // Every candidate is drawn afresh rather than stepped from the last one,
+    // which would favour primes that follow long prime gaps. Most composites
+    // have a small factor, so trial division returns early for them.
+    size_t k = 0;
+    while (k < num_primes && mpz_fdiv_ui(p, primes[k]) != 0) {
+      k++;
+    }
+    if (k == num_primes && mpz_probab_prime_p(p, kPrimalityReps)) {
+      return;
+    }
+  }
+}
+
+}  // namespace tf_big
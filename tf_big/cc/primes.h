@@ -0,0 +1,24 @@
+#ifndef TF_BIG_CC_PRIMES_H_
+#define TF_BIG_CC_PRIMES_H_
+
+#include <gmp.h>
+
+#include <cstddef>
+
+#include "tf_big/cc/random.h"
+
+namespace tf_big {
+
+// Sets `p` to a random probable prime of exactly `bits` bits, `bits` >= 3,
+// drawing the candidates from `stream`.
+//
+// The two most significant bits are always set, so that the product of two
+// such primes has exactly the sum of their bit lengths. Every candidate is a
+// fresh uniformly random odd number, so that all primes of the size are
+// equally likely, and trial division by a table of small primes screens out
+// most of them before the probabilistic test runs.
+void RandomPrime(mpz_ptr p, size_t bits, ChaChaStream* stream);
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_PRIMES_H_
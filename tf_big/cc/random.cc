@@ -0,0 +1,100 @@
+#include "tf_big/cc/random.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tf_big {
+
+namespace {
+
+inline uint32_t Rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+inline void QuarterRound(uint32_t* x, int a, int b, int c, int d) {
+  x[a] += x[b];
+  x[d] = Rotl(x[d] ^ x[a], 16);
+  x[c] += x[d];
+  x[b] = Rotl(x[b] ^ x[c], 12);
+  x[a] += x[b];
+  x[d] = Rotl(x[d] ^ x[a], 8);
+  x[c] += x[d];
+  x[b] = Rotl(x[b] ^ x[c], 7);
+}
+
+}  // namespace
+
+ChaChaStream::ChaChaStream(const Key& key, uint64_t nonce, uint64_t counter)
+    : pos_(kBlockWords) {
+  // "expand 32-byte k"
+  state_[0] = 0x61707865;
+  state_[1] = 0x3320646e;
+  state_[2] = 0x79622d32;
+  state_[3] = 0x6b206574;
+  for (int i = 0; i < 8; i++) {
+    state_[4 + i] = key[i];
+  }
+  state_[12] = static_cast<uint32_t>(counter);
+  state_[13] = static_cast<uint32_t>(counter >> 32);
+  state_[14] = static_cast<uint32_t>(nonce);
+  state_[15] = static_cast<uint32_t>(nonce >> 32);
+}
+
+void ChaChaStream::Refill() {
+  block_ = state_;
+  uint32_t* x = block_.data();
+  for (int round = 0; round < 10; round++) {
+    QuarterRound(x, 0, 4, 8, 12);
+    QuarterRound(x, 1, 5, 9, 13);
+    QuarterRound(x, 2, 6, 10, 14);
+    QuarterRound(x, 3, 7, 11, 15);
+    QuarterRound(x, 0, 5, 10, 15);
+    QuarterRound(x, 1, 6, 11, 12);
+    QuarterRound(x, 2, 7, 8, 13);
+    QuarterRound(x, 3, 4, 9, 14);
+  }
+  for (int i = 0; i < kBlockWords; i++) {
+    block_[i] += state_[i];
+  }
+
+  if (++state_[12] == 0) {
+    ++state_[13];
+  }
+  pos_ = 0;
+}
+
+bool RandomKey(ChaChaStream::Key* key) {
+  int file = open("/dev/urandom", O_RDONLY);
+  if (file == -1) {
+    return false;
+  }
+  auto buffer = reinterpret_cast<char*>(key->data());
+  size_t remaining = sizeof(*key);
+  while (remaining > 0) {
+    ssize_t count = read(file, buffer, remaining);
+    if (count <= 0) {
+      close(file);
+      return false;
+    }
+    buffer += count;
+    remaining -= count;
+  }
+  close(file);
+  return true;
+}
+
+void RandomBelow(mp_limb_t* rp, const mp_limb_t* bound, mp_size_t n,
+                 ChaChaStream* stream) {
+  static_assert(GMP_NUMB_BITS == 64, "limbs are filled 64 bits at a time");
+
+  int top_bits = GMP_NUMB_BITS - __builtin_clzll(bound[n - 1]);
+  mp_limb_t top_mask = top_bits == GMP_NUMB_BITS
+                           ? ~mp_limb_t(0)
+                           : (mp_limb_t(1) << top_bits) - 1;
+  do {
+    for (mp_size_t i = 0; i < n; i++) {
+      rp[i] = stream->Next();
+    }
+    rp[n - 1] &= top_mask;
+  } while (mpn_cmp(rp, bound, n) >= 0);
+}
+
+}  // namespace tf_big
@@ -0,0 +1,58 @@
+#ifndef TF_BIG_CC_RANDOM_H_
+#define TF_BIG_CC_RANDOM_H_
+
+#include <gmp.h>
+
+#include <array>
+#include <cstdint>
+
+namespace tf_big {
+
+// Keystream of the ChaCha20 stream cipher, in the original variant with a
+// 64-bit block counter and a 64-bit nonce, used as a cryptographically secure
+// random number generator.
+//
+// Distinct (key, nonce) pairs give independent streams, and the output for a
+// given position only depends on the key, nonce and counter, so that work can
+// be split across threads while staying reproducible.
+class ChaChaStream {
+ public:
+  typedef std::array<uint32_t, 8> Key;
+
+  // Starts the stream with the given nonce at block `counter`.
+  ChaChaStream(const Key& key, uint64_t nonce, uint64_t counter = 0);
+
+  // Returns the next 64 bits of the keystream.
+  uint64_t Next() {
+    if (pos_ == kBlockWords) {
+      Refill();
+    }
+    uint64_t lo = block_[pos_++];
+    uint64_t hi = block_[pos_++];
+    return lo | hi << 32;
+  }
+
+ private:
+  static const int kBlockWords = 16;
+
+  void Refill();
+
+  std::array<uint32_t, kBlockWords> state_;
+  std::array<uint32_t, kBlockWords> block_;
+  int pos_;
+};
+
+// Draws a key from the operating system's entropy source; returns false if
+// none is available.
+bool RandomKey(ChaChaStream::Key* key);
+
+// Sets the n-limb vector rp to a uniformly random value in [0, bound), where
+// `bound` has n limbs and a non-zero top limb, by rejection sampling on
+// values with as many bits as `bound`; on average fewer than two draws are
+// needed.
+void RandomBelow(mp_limb_t* rp, const mp_limb_t* bound, mp_size_t n,
+                 ChaChaStream* stream);
+
+}  // namespace tf_big
+
+#endif  // TF_BIG_CC_RANDOM_H_
@@ -0,0 +1,55 @@
+#include "tf_big/cc/random.h"
+
+#include "gtest/gtest.h"
+
+namespace tf_big {
+namespace {
+
+// The block function test vector of RFC 7539, section 2.3.2. Its 32-bit
+// counter and 96-bit nonce are state words 12 to 15, which this variant
+// splits into a 64-bit counter and a 64-bit nonce instead.
+TEST(ChaChaStreamTest, Rfc7539BlockFunction) {
+  ChaChaStream::Key key;
+  for (int i = 0; i < 8; i++) {
+    key[i] = 0x03020100 + 0x04040404 * i;  // bytes 00 01 02 ... 1f
+  }
+  uint64_t counter = uint64_t(0x09000000) << 32 | 1;
+  ChaChaStream stream(key, /*nonce=*/0x4a000000, counter);
+
+  const uint32_t expected[16] = {
+      0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3,
+      0xc7f4d1c7, 0x0368c033, 0x9aaa2204, 0x4e6cd4c3,
+      0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9,
+      0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2,
+  };
+  for (int i = 0; i < 16; i += 2) {
+    EXPECT_EQ(stream.Next(), expected[i] | uint64_t(expected[i + 1]) << 32)
+        << "words " << i << " and " << i + 1;
+  }
+}
+
+TEST(ChaChaStreamTest, CounterCarriesIntoHighWord) {
+  ChaChaStream::Key key = {};
+  ChaChaStream wrapped(key, 7, 0xffffffff);
+  for (int i = 0; i < 8; i++) {
+    wrapped.Next();
+  }
+  ChaChaStream next(key, 7, uint64_t(1) << 32);
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(wrapped.Next(), next.Next());
+  }
+}
+
+TEST(RandomBelowTest, StaysBelowBound) {
+  ChaChaStream::Key key = {};
+  ChaChaStream stream(key, 0);
+  const mp_limb_t bound[2] = {0, 5};
+  mp_limb_t r[2];
+  for (int i = 0; i < 1000; i++) {
+    RandomBelow(r, bound, 2, &stream);
+    EXPECT_LT(mpn_cmp(r, bound, 2), 0);
+  }
+}
+
+}  // namespace
+}  // namespace tf_big
@@ -19,6 +19,36 @@ big_sub = big_ops.big_sub
 big_mul = big_ops.big_mul
 big_div = big_ops.big_div
 big_pow = big_ops.big_pow
+big_pow_crt = big_ops.big_pow_crt
 big_matmul = big_ops.big_mat_mul
+big_matmul_mod = big_ops.big_mat_mul_mod
 big_mod = big_ops.big_mod
 big_inv = big_ops.big_inv
+big_reduce_sum = big_ops.big_reduce_sum
+big_reduce_prod_mod = big_ops.big_reduce_prod_mod
+
+big_slice = big_ops.big_slice
+big_gather = big_ops.big_gather
+big_concat = big_ops.big_concat
+big_reshape = big_ops.big_reshape
+big_transpose = big_ops.big_transpose
+
+big_mul_mod = big_ops.big_mul_mod
+big_add_mod = big_ops.big_add_mod
+big_sub_mod = big_ops.big_sub_mod
+
+big_to_montgomery = big_ops.big_to_montgomery
+big_from_montgomery = big_ops.big_from_montgomery
+big_montgomery_mul = big_ops.big_montgomery_mul
+big_montgomery_add = big_ops.big_montgomery_add
+big_montgomery_sub = big_ops.big_montgomery_sub
+big_montgomery_pow = big_ops.big_montgomery_pow
+
+big_fixed_base_table = big_ops.big_fixed_base_table
+big_pow_fixed_base = big_ops.big_pow_fixed_base
+
+big_obfuscator_pool = big_ops.big_obfuscator_pool
+big_obfuscator_pool_pop = big_ops.big_obfuscator_pool_pop
+
+big_kernel_counters = big_ops.big_kernel_counters
+big_gmp_memory_stats = big_ops.big_gmp_memory_stats
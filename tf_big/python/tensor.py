@@ -1,3 +1,4 @@
+import itertools
 from typing import Optional
 
 import numpy as np
@@ -39,50 +40,44 @@ class Tensor(object):
 
     def __add__(self, other):
         other = import_tensor(other)
-        # TODO (Yann) This broadcast should be implemented
-        # in big_kernels.cc
-        self, other = broadcast(self, other)
         res = ops.big_add(self._raw, other._raw)
         return Tensor(res)
 
     def __radd__(self, other):
         other = import_tensor(other)
-        # TODO (Yann) This broadcast should be implemented
-        # in big_kernels.cc
-        self, other = broadcast(self, other)
         res = ops.big_add(self._raw, other._raw)
         return Tensor(res)
 
     def __sub__(self, other):
         other = import_tensor(other)
-        # TODO (Yann) This broadcast should be implemented
-        # in big_kernels.cc
-        self, other = broadcast(self, other)
         res = ops.big_sub(self._raw, other._raw)
         return Tensor(res)
 
     def __mul__(self, other):
         other = import_tensor(other)
-        # TODO (Yann) This broadcast should be implemented
-        # in big_kernels.cc
-        self, other = broadcast(self, other)
         res = ops.big_mul(self._raw, other._raw)
         return Tensor(res)
 
     def __floordiv__(self, other):
         other = import_tensor(other)
-        # TODO (Yann) This broadcast should be implemented
-        # in big_kernels.cc
-        self, other = broadcast(self, other)
         res = ops.big_div(self._raw, other._raw)
         return Tensor(res)
 
+    def matmul(self, other):
+        other = import_tensor(other)
+        res = ops.big_matmul(self._raw, other._raw)
+        return Tensor(res)
+
+    def matmul_mod(self, other, modulus):
+        """Computes `(self @ other) % modulus` without the unreduced product."""
+        other = import_tensor(other)
+        modulus = import_tensor(modulus)
+        res = ops.big_matmul_mod(self._raw, other._raw, modulus._raw)
+        return Tensor(res)
+
     def pow(self, exponent, modulus=None, secure=None):
-        # TODO (Yann) This broadcast should be implemented
-        # in big_kernels.cc
         exponent = import_tensor(exponent)
         modulus = import_tensor(modulus)
-        self, exponent = broadcast(self, exponent)
         res = ops.big_pow(
             base=self._raw,
             exponent=exponent._raw,
@@ -99,9 +94,34 @@ class Tensor(object):
         res = ops.big_mod(val=self._raw, mod=modulus._raw)
         return Tensor(res)
 
-    def inv(self, modulus):
+    def inv(self, modulus, batched=False):
+        """Computes the inverse of every element modulo `modulus`, or zero where
+        none exists. With `batched` all inverses are derived from one inversion
+        per chunk using Montgomery's trick, which is much faster for large
+        tensors."""
+        modulus = import_tensor(modulus)
+        res = ops.big_inv(val=self._raw, mod=modulus._raw, batched=batched)
+        return Tensor(res)
+
+    def mul_mod(self, other, modulus):
+        """Computes `(self * other) % modulus` without the unreduced product."""
+        other = import_tensor(other)
         modulus = import_tensor(modulus)
-        res = ops.big_inv(val=self._raw, mod=modulus._raw)
+        res = ops.big_mul_mod(self._raw, other._raw, modulus._raw)
+        return Tensor(res)
+
+    def add_mod(self, other, modulus):
+        """Computes `(self + other) % modulus` without the unreduced sum."""
+        other = import_tensor(other)
+        modulus = import_tensor(modulus)
+        res = ops.big_add_mod(self._raw, other._raw, modulus._raw)
+        return Tensor(res)
+
+    def sub_mod(self, other, modulus):
+        """Computes `(self - other) % modulus` without the unreduced difference."""
+        other = import_tensor(other)
+        modulus = import_tensor(modulus)
+        res = ops.big_sub_mod(self._raw, other._raw, modulus._raw)
         return Tensor(res)
 
 
@@ -167,56 +187,85 @@ def _convert_to_numpy_tensor(tensor):
     raise ValueError("Cannot convert to NumPy tensor: '{}'".format(type(tensor)))
 
 
-def _import_tensor_numpy(tensor):
+def _import_tensor_numpy(tensor, storage, string_format):
     tensor = _convert_to_numpy_tensor(tensor)
 
-    if np.issubdtype(tensor.dtype, np.int64) or np.issubdtype(tensor.dtype, np.object_):
+    # object arrays hold either Python ints or strings already in `string_format`
+    if np.issubdtype(tensor.dtype, np.object_) and string_format == "decimal":
         tensor = tensor.astype(np.string_)
     elif not (
         np.issubdtype(tensor.dtype, np.int32)
+        or np.issubdtype(tensor.dtype, np.int64)
+        or np.issubdtype(tensor.dtype, np.uint64)
         or np.issubdtype(tensor.dtype, np.string_)
         or np.issubdtype(tensor.dtype, np.unicode_)
+        or np.issubdtype(tensor.dtype, np.object_)
     ):
         raise ValueError("Unsupported dtype '{}'.".format(tensor.dtype))
 
     if len(tensor.shape) != 2:
         raise ValueError("Tensors must have rank 2.")
 
-    return Tensor(ops.big_import(tensor))
+    return Tensor(ops.big_import(tensor, storage=storage, string_format=string_format))
 
 
-def _import_tensor_tensorflow(tensor):
-    if tensor.dtype in [tf.int64]:
-        tensor = tf.as_string(tensor)
-    elif tensor.dtype not in [tf.uint8, tf.int32, tf.string]:
+def _import_tensor_tensorflow(tensor, storage, string_format):
+    if tensor.dtype not in [tf.uint8, tf.int32, tf.int64, tf.uint64, tf.string]:
         raise ValueError("Unsupported dtype '{}'".format(tensor.dtype))
 
     if len(tensor.shape) != 2:
         raise ValueError("Tensor must have rank 2.")
 
-    return Tensor(ops.big_import(tensor))
+    return Tensor(ops.big_import(tensor, storage=storage, string_format=string_format))
+
+
+def import_tensor(tensor, storage=None, string_format="decimal"):
+    """Imports `tensor` as a big tensor.
 
+    `storage` selects the internal representation: "mpz", the default, keeps one
+    GMP integer per element while "limbs" packs all elements into a single
+    fixed-width limb buffer, which is faster for large tensors of similarly
+    sized values. Big tensors are returned as they are, so `storage` cannot be
+    given for them.
 
-def import_tensor(tensor):
+    `string_format` applies to string inputs and is one of "decimal", "hex"
+    (base 16 without prefix) or "bytes" (big-endian magnitude). Since NumPy
+    fixed-width byte strings drop trailing zero bytes, "bytes" input should be
+    given as a `tf.Tensor` or an object array.
+    """
     if isinstance(tensor, Tensor):
+        if storage is not None:
+            raise ValueError("Cannot change the storage of a big tensor")
         return tensor
+    storage = storage or "mpz"
     if isinstance(tensor, tf.Tensor):
-        return _import_tensor_tensorflow(tensor)
-    return _import_tensor_numpy(tensor)
+        return _import_tensor_tensorflow(tensor, storage, string_format)
+    return _import_tensor_numpy(tensor, storage, string_format)
 
 
-def export_tensor(tensor, dtype=None):
-    assert isinstance(tensor, Tensor), type(value)
+def export_tensor(tensor, dtype=None, checked=False, string_format="decimal"):
+    """Exports `tensor` as a regular TensorFlow tensor of the given `dtype`.
+
+    Integer dtypes keep the low bits of each value, like a C cast, unless
+    `checked` is set in which case values out of range are an error. String
+    output uses `string_format` as in `import_tensor`.
+    """
+    assert isinstance(tensor, Tensor), type(tensor)
 
     dtype = dtype or tf.string
-    if dtype not in [tf.int32, tf.string]:
+    if dtype not in [tf.int32, tf.uint8, tf.int64, tf.uint64, tf.string]:
         raise ValueError("Unsupported dtype '{}'".format(dtype))
 
-    return ops.big_export(tensor._raw, dtype=dtype)
+    return ops.big_export(
+        tensor._raw, dtype=dtype, checked=checked, string_format=string_format
+    )
+
 
+_LIMB_DTYPES = [tf.uint8, tf.int32, tf.int64, tf.uint32, tf.uint64]
 
-def _import_limbs_tensor_tensorflow(limbs_tensor):
-    if limbs_tensor.dtype not in [tf.uint8, tf.int32]:
+
+def _import_limbs_tensor_tensorflow(limbs_tensor, storage, layout):
+    if limbs_tensor.dtype not in _LIMB_DTYPES:
         raise ValueError(
             "Not implemented limb conversion for dtype {}".format(limbs_tensor.dtype)
         )
@@ -224,43 +273,56 @@ def _import_limbs_tensor_tensorflow(limbs_tensor):
     if len(limbs_tensor.shape) != 3:
         raise ValueError("Limbs tensors must be rank 3.")
 
-    return Tensor(ops.big_import_limbs(limbs_tensor))
+    return Tensor(ops.big_import_limbs(limbs_tensor, storage=storage, layout=layout))
 
 
-def _import_limbs_tensor_numpy(limbs_tensor):
+def _import_limbs_tensor_numpy(limbs_tensor, storage, layout):
     limbs_tensor = _convert_to_numpy_tensor(limbs_tensor)
 
-    if len(tensor.shape) != 3:
+    if len(limbs_tensor.shape) != 3:
         raise ValueError("Limbs tensors must have rank 3.")
 
-    if not (
-        np.issubdtype(limbs_tensor.dtype, np.int32)
-        or np.issubdtype(limbs_tensor.dtype, np.uint8)
+    if not any(
+        np.issubdtype(limbs_tensor.dtype, dtype.as_numpy_dtype)
+        for dtype in _LIMB_DTYPES
     ):
         raise ValueError(
-            "Not implemented limb conversion for dtype {}".format(tensor.dtype)
+            "Not implemented limb conversion for dtype {}".format(limbs_tensor.dtype)
         )
 
-    return Tensor(ops.big_import_limbs(limbs_tensor))
+    return Tensor(ops.big_import_limbs(limbs_tensor, storage=storage, layout=layout))
+
 
+def import_limbs_tensor(limbs_tensor, storage="mpz", layout="header"):
+    """Imports a rank-3 tensor of limbs as a big tensor.
 
-def import_limbs_tensor(limbs_tensor):
+    `layout` must match the one used by `export_limbs_tensor`.
+    """
     if isinstance(limbs_tensor, tf.Tensor):
-        return _import_limbs_tensor_tensorflow(limbs_tensor)
-    return _import_limbs_tensor_numpy(limbs_tensor)
+        return _import_limbs_tensor_tensorflow(limbs_tensor, storage, layout)
+    return _import_limbs_tensor_numpy(limbs_tensor, storage, layout)
 
 
-def export_limbs_tensor(tensor, dtype=None, max_bitlen=None):
-    assert isinstance(tensor, Tensor), type(value)
+def export_limbs_tensor(tensor, dtype=None, max_bitlen=None, layout="header"):
+    """Exports `tensor` as a rank-3 tensor of limbs of the given `dtype`.
+
+    With the "header" layout every element starts with its length in bytes
+    followed by its big-endian bytes. The "fixed" layout has no header and
+    stores each element as native-endian words, least significant first, which
+    for 64-bit dtypes is a plain copy of GMP's limbs.
+    """
+    assert isinstance(tensor, Tensor), type(tensor)
 
     # Indicate missing value as negative
     max_bitlen = max_bitlen or -1
 
     dtype = dtype or tf.uint8
-    if dtype not in [tf.uint8, tf.int32]:
+    if dtype not in _LIMB_DTYPES:
         raise ValueError("Unsupported dtype '{}'".format(dtype))
 
-    return ops.big_export_limbs(tensor._raw, dtype=dtype, max_bitlen=max_bitlen)
+    return ops.big_export_limbs(
+        tensor._raw, dtype=dtype, max_bitlen=max_bitlen, layout=layout
+    )
 
 
 _SECURE = True
@@ -275,15 +337,29 @@ def get_secure_default():
     return _SECURE
 
 
-def random_uniform(shape, maxval):
+def random_uniform(shape, maxval, seed=None, stream=0):
+    """Draws a tensor of the given shape uniformly from `[0, maxval)`.
+
+    Values come from a ChaCha20-based generator keyed from system randomness on
+    every run. Passing `seed`, an integer or a list of up to four 64-bit
+    integers, instead makes the output a deterministic function of the seed and
+    `stream`; different streams give independent values under the same seed.
+    """
     if not isinstance(maxval, Tensor):
         maxval = import_tensor(maxval)
-    r_raw = ops.big_random_uniform(shape, maxval._raw)
+    if seed is None:
+        seed = []
+    elif isinstance(seed, int):
+        seed = [seed]
+    r_raw = ops.big_random_uniform(shape, maxval._raw, seed=seed, stream=stream)
     return Tensor(r_raw)
 
 
-def random_rsa_modulus(bitlength):
-    p_raw, q_raw, n_raw = ops.big_random_rsa_modulus(bitlength)
+def random_rsa_modulus(bitlength, batch_size=1):
+    """Generates `batch_size` RSA moduli n = p * q of exactly `bitlength` bits,
+    returned together with their prime factors as tensors of shape
+    `(batch_size, 1)`."""
+    p_raw, q_raw, n_raw = ops.big_random_rsa_modulus(bitlength, batch_size=batch_size)
     return Tensor(p_raw), Tensor(q_raw), Tensor(n_raw)
 
 
@@ -308,6 +384,24 @@ def pow(base, exponent, modulus=None, secure=None):
     return base.pow(exponent=exponent, modulus=modulus, secure=secure)
 
 
+def pow_crt(base, exponent, p, q, squared=False, secure=None):
+    """Computes `base ** exponent` modulo `p * q`, or `(p * q) ** 2` when
+    `squared` is set, using the Chinese Remainder Theorem on the factors."""
+    base = import_tensor(base)
+    exponent = import_tensor(exponent)
+    p = import_tensor(p)
+    q = import_tensor(q)
+    res = ops.big_pow_crt(
+        base=base._raw,
+        exponent=exponent._raw,
+        p=p._raw,
+        q=q._raw,
+        squared=squared,
+        secure=secure if secure is not None else get_secure_default(),
+    )
+    return Tensor(res)
+
+
 def matmul(x, y):
     # TODO(Morten) lifting etc
     return x.matmul(y)
@@ -317,45 +411,204 @@ def mod(x, n):
     return x.mod(n)
 
 
-def inv(x, n):
-    return x.inv(n)
+def inv(x, n, batched=False):
+    return x.inv(n, batched=batched)
+
+
+def _normalize_axis(axis):
+    # Big tensors are matrices, so negative axes count back from 2.
+    return axis + 2 if axis < 0 else axis
+
+
+def _reduce_attrs(axis):
+    if axis is None:
+        return {"reduce_all": True}
+    return {"axis": _normalize_axis(axis)}
 
 
-def broadcast(x, y):
+def reduce_sum(x, axis=None):
+    """Sums the elements of `x` along `axis`, or all of them if `axis` is None.
 
-    x_rank = x.shape.rank
-    y_rank = y.shape.rank
-    x_nb_el = x.shape.num_elements()
-    y_nb_el = y.shape.num_elements()
+    The reduced dimension is kept with size one, so the result is a matrix.
+    """
+    x = import_tensor(x)
+    return Tensor(ops.big_reduce_sum(x._raw, **_reduce_attrs(axis)))
 
-    # e.g broadcast [1] with [1, 1]
-    if x_rank != y_rank:
 
-        if x_rank < y_rank:
-            x = export_tensor(x)
-            x = tf.broadcast_to(x, y.shape)
-            x = import_tensor(x)
+def reduce_prod_mod(x, modulus, axis=None):
+    """Multiplies the elements of `x` modulo `modulus` along `axis`, or all of
+    them if `axis` is None; this adds up Paillier ciphertexts modulo n^2.
 
-        elif y_rank < x_rank:
-            y = export_tensor(y)
-            y = tf.broadcast_to(y, x.shape)
-            y = import_tensor(y)
+    The reduced dimension is kept with size one, so the result is a matrix.
+    """
+    x = import_tensor(x)
+    modulus = import_tensor(modulus)
+    return Tensor(
+        ops.big_reduce_prod_mod(x._raw, modulus._raw, **_reduce_attrs(axis))
+    )
 
-        return x, y
 
-    # e.g broadcast [1, 1] with [1, 2]
-    elif x_nb_el != y_nb_el:
+def slice(x, begin, size):
+    """Extracts the `size[0]` x `size[1]` block of `x` starting at `begin`; a
+    size of -1 extends the block to the end of that dimension."""
+    x = import_tensor(x)
+    begin = tf.convert_to_tensor(begin, dtype=tf.int32)
+    size = tf.convert_to_tensor(size, dtype=tf.int32)
+    return Tensor(ops.big_slice(x._raw, begin, size))
 
-        if x_nb_el < y_nb_el:
-            x = export_tensor(x)
-            x = tf.broadcast_to(x, y.shape)
-            x = import_tensor(x)
 
-        elif x_nb_el > y_nb_el:
-            y = export_tensor(y)
-            y = tf.broadcast_to(y, x.shape)
-            y = import_tensor(y)
+def gather(x, indices, axis=0):
+    """Gathers the rows (axis 0) or columns (axis 1) of `x` given by `indices`."""
+    x = import_tensor(x)
+    indices = tf.convert_to_tensor(indices)
+    return Tensor(ops.big_gather(x._raw, indices, axis=_normalize_axis(axis)))
 
-        return x, y
 
-    return x, y
+def concat(values, axis):
+    """Concatenates big tensors along `axis`."""
+    values = [import_tensor(value)._raw for value in values]
+    return Tensor(ops.big_concat(values, axis=_normalize_axis(axis)))
+
+
+def reshape(x, shape):
+    """Reshapes `x` into a matrix of the given shape, keeping the elements in
+    row-major order as `tf.reshape` does; one dimension may be -1."""
+    x = import_tensor(x)
+    shape = tf.convert_to_tensor(shape, dtype=tf.int32)
+    return Tensor(ops.big_reshape(x._raw, shape))
+
+
+def transpose(x):
+    x = import_tensor(x)
+    return Tensor(ops.big_transpose(x._raw))
+
+
+def to_montgomery(x, modulus):
+    """Converts `x` into the Montgomery domain modulo an odd `modulus`."""
+    x = import_tensor(x)
+    modulus = import_tensor(modulus)
+    return Tensor(ops.big_to_montgomery(x._raw, modulus._raw))
+
+
+def from_montgomery(x, modulus):
+    """Converts `x` out of the Montgomery domain modulo `modulus`."""
+    x = import_tensor(x)
+    modulus = import_tensor(modulus)
+    return Tensor(ops.big_from_montgomery(x._raw, modulus._raw))
+
+
+def montgomery_mul(x, y, modulus):
+    x = import_tensor(x)
+    y = import_tensor(y)
+    modulus = import_tensor(modulus)
+    return Tensor(ops.big_montgomery_mul(x._raw, y._raw, modulus._raw))
+
+
+def montgomery_add(x, y, modulus):
+    x = import_tensor(x)
+    y = import_tensor(y)
+    modulus = import_tensor(modulus)
+    return Tensor(ops.big_montgomery_add(x._raw, y._raw, modulus._raw))
+
+
+def montgomery_sub(x, y, modulus):
+    x = import_tensor(x)
+    y = import_tensor(y)
+    modulus = import_tensor(modulus)
+    return Tensor(ops.big_montgomery_sub(x._raw, y._raw, modulus._raw))
+
+
+def montgomery_pow(base, exponent, modulus):
+    base = import_tensor(base)
+    exponent = import_tensor(exponent)
+    modulus = import_tensor(modulus)
+    return Tensor(ops.big_montgomery_pow(base._raw, exponent._raw, modulus._raw))
+
+
+_FIXED_BASE_TABLE_IDS = itertools.count()
+
+
+class FixedBaseTable(object):
+    """Precomputed powers of a fixed `base` modulo an odd `modulus`.
+
+    The table is built the first time it is used and then kept in the resource
+    manager, so repeated `pow` calls, including across `Session.run` calls, only
+    pay for table lookups and multiplications. Exponents longer than
+    `max_bitlen` bits are still supported but fall back to a regular
+    exponentiation.
+    """
+
+    def __init__(self, base, modulus, max_bitlen, window=4, shared_name=None):
+        base = import_tensor(base)
+        modulus = import_tensor(modulus)
+        if shared_name is None:
+            shared_name = "fixed_base_table_{}".format(next(_FIXED_BASE_TABLE_IDS))
+        self._handle = ops.big_fixed_base_table(
+            base._raw,
+            modulus._raw,
+            max_bitlen,
+            window=window,
+            shared_name=shared_name,
+        )
+
+    def pow(self, exponent):
+        exponent = import_tensor(exponent)
+        return Tensor(ops.big_pow_fixed_base(self._handle, exponent._raw))
+
+
+_OBFUSCATOR_POOL_IDS = itertools.count()
+
+
+class ObfuscatorPool(object):
+    """Paillier obfuscators `r^n mod n^2` computed ahead of time.
+
+    A background thread keeps up to `capacity` obfuscators ready for the odd
+    `modulus` n, starting the first time the pool is used. Popping more than
+    are ready computes the remainder on the spot rather than waiting.
+    """
+
+    def __init__(self, modulus, capacity=1024, shared_name=None):
+        modulus = import_tensor(modulus)
+        if shared_name is None:
+            shared_name = "obfuscator_pool_{}".format(next(_OBFUSCATOR_POOL_IDS))
+        self._handle = ops.big_obfuscator_pool(
+            modulus._raw, capacity=capacity, shared_name=shared_name,
+        )
+
+    def pop(self, shape):
+        shape = tf.convert_to_tensor(shape, dtype=tf.int32)
+        return Tensor(ops.big_obfuscator_pool_pop(self._handle, shape))
+
+
+def kernel_counters():
+    """Returns cumulative statistics of the big kernels run in this process.
+
+    The result is a dict of equally long vectors, with one entry per op type
+    that has run: "op" holds the op type names and "calls", "elements",
+    "limb_ops" and "wall_nanos" the corresponding totals. `limb_ops` is the
+    work estimated by the kernels' cost model rather than an exact count.
+    """
+    outputs = ops.big_kernel_counters()
+    keys = ["op", "calls", "elements", "limb_ops", "wall_nanos"]
+    return dict(zip(keys, outputs))
+
+
+def gmp_memory_stats():
+    """Returns statistics of the memory GMP allocated in this process.
+
+    The result is a dict of scalars: "allocations" and "pool_hits" count the
+    allocations made and those served from the thread-local block caches,
+    "bytes_allocated" is the cumulative number of bytes requested,
+    "bytes_in_use" the bytes held by live values, and "bytes_cached" the bytes
+    of freed blocks kept for reuse. The caches can be disabled by setting
+    TF_BIG_GMP_POOL=0 before loading the library.
+    """
+    outputs = ops.big_gmp_memory_stats()
+    keys = [
+        "allocations",
+        "pool_hits",
+        "bytes_allocated",
+        "bytes_in_use",
+        "bytes_cached",
+    ]
+    return dict(zip(keys, outputs))
@@ -1,16 +1,38 @@
+import math
 import unittest
 
 import numpy as np
 import tensorflow as tf
 from absl.testing import parameterized
+from tensorflow.core.framework import tensor_pb2
+from tensorflow.core.framework import types_pb2
 
+from tf_big.python.tensor import FixedBaseTable
+from tf_big.python.tensor import ObfuscatorPool
+from tf_big.python.tensor import Tensor
+from tf_big.python.tensor import concat
 from tf_big.python.tensor import export_limbs_tensor
 from tf_big.python.tensor import export_tensor
+from tf_big.python.tensor import from_montgomery
+from tf_big.python.tensor import gather
+from tf_big.python.tensor import gmp_memory_stats
 from tf_big.python.tensor import import_limbs_tensor
 from tf_big.python.tensor import import_tensor
+from tf_big.python.tensor import kernel_counters
+from tf_big.python.tensor import montgomery_add
+from tf_big.python.tensor import montgomery_mul
+from tf_big.python.tensor import montgomery_pow
+from tf_big.python.tensor import montgomery_sub
 from tf_big.python.tensor import pow
+from tf_big.python.tensor import pow_crt
 from tf_big.python.tensor import random_rsa_modulus
 from tf_big.python.tensor import random_uniform
+from tf_big.python.tensor import reduce_prod_mod
+from tf_big.python.tensor import reduce_sum
+from tf_big.python.tensor import reshape
+from tf_big.python.tensor import slice
+from tf_big.python.tensor import to_montgomery
+from tf_big.python.tensor import transpose
 from tf_big.python.test import tf_execution_context
 
 
@@ -49,6 +71,24 @@ class RandomTest(parameterized.TestCase):
         assert x.shape == shape
         assert context.evaluate(x).shape == shape
 
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_uniform_random_seeded(self, run_eagerly):
+        shape = (3, 4)
+        maxval = 2 ** 200 + 3
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = export_tensor(random_uniform(shape, maxval, seed=[1, -2]))
+            y = export_tensor(random_uniform(shape, maxval, seed=[1, -2]))
+            z = export_tensor(random_uniform(shape, maxval, seed=[1, -2], stream=1))
+
+        x = context.evaluate(x).astype(str)
+        np.testing.assert_array_equal(x, context.evaluate(y).astype(str))
+        assert not np.any(x == context.evaluate(z).astype(str))
+        assert all(0 <= int(v) < maxval for v in x.flatten())
+
     @parameterized.parameters(
         {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
     )
@@ -72,6 +112,32 @@ class RandomTest(parameterized.TestCase):
         assert isinstance(context.evaluate(q)[0][0], bytes)
         assert isinstance(context.evaluate(n)[0][0], bytes)
 
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_random_rsa_modulus_batch(self, run_eagerly):
+        bitlength = 255
+        batch_size = 3
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            p, q, n = random_rsa_modulus(bitlength=bitlength, batch_size=batch_size)
+
+            p = export_tensor(p)
+            q = export_tensor(q)
+            n = export_tensor(n)
+
+        assert n.shape == (batch_size, 1)
+
+        p = [int(v) for v in context.evaluate(p)[:, 0]]
+        q = [int(v) for v in context.evaluate(q)[:, 0]]
+        n = [int(v) for v in context.evaluate(n)[:, 0]]
+        for p_i, q_i, n_i in zip(p, q, n):
+            assert p_i != q_i
+            assert p_i * q_i == n_i
+            assert n_i.bit_length() == bitlength
+            assert p_i % 2 == 1 and q_i % 2 == 1
+
 
 class ArithmeticTest(parameterized.TestCase):
     @parameterized.parameters(
@@ -138,6 +204,255 @@ class ArithmeticTest(parameterized.TestCase):
             context.evaluate(z).astype(str), z_raw.astype(str)
         )
 
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "squared": squared}
+        for run_eagerly in (True, False)
+        for squared in (False, True)
+    )
+    def test_pow_crt(self, run_eagerly, squared):
+        p = 2 ** 89 - 1
+        q = 2 ** 107 - 1
+        n = (p * q) ** 2 if squared else p * q
+
+        # Includes bases sharing a factor with the modulus.
+        x_raw = np.array([[3 ** 80], [5 * p], [q ** 2 + 1], [n - 1]])
+        y_raw = np.array([[0, 1, 2 ** 300 + 12345]])
+        # `pow` is tf_big's here, so use int's three-argument form directly.
+        z_raw = np.array(
+            [[int.__pow__(int(b), int(e), n) for e in y_raw[0]] for b in x_raw[:, 0]]
+        )
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            y = import_tensor(y_raw)
+            z = pow_crt(x, y, np.array([[p]]), np.array([[q]]), squared=squared)
+
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "op": op}
+        for run_eagerly in (True, False)
+        for op in (
+            lambda x, y: x + y,
+            lambda x, y: x - y,
+            lambda x, y: x * y,
+            lambda x, y: x // y,
+        )
+    )
+    def test_broadcast(self, run_eagerly, op):
+        x_raw = np.array([[2 ** 100], [3 ** 50]])
+        y_raw = np.array([[7, 2 ** 65, 11]])
+        z_raw = op(x_raw, y_raw)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            y = import_tensor(y_raw)
+            z = op(x, y)
+            assert z.shape.as_list() == [2, 3], z.shape
+
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_chain(self, run_eagerly):
+        # Intermediates without other consumers are updated in place, while
+        # those used more than once must be left intact.
+        x_raw = np.array([[2 ** 100, 3], [5, -(7 ** 40)]])
+        y_raw = np.array([[11, 2 ** 70]])
+        m_raw = np.array([[2 ** 61 - 1]])
+
+        w_raw = x_raw * x_raw + y_raw
+        z_raw = ((w_raw * w_raw - w_raw) // y_raw) % m_raw
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            y = import_tensor(y_raw)
+            m = import_tensor(m_raw)
+            w = x * x + y
+            z = ((w * w - w) // y) % m
+
+            w = export_tensor(w)
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(w).astype(str), w_raw.astype(str)
+        )
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "m": m, "k": k, "n": n}
+        for run_eagerly in (True, False)
+        # several tiles with ragged edges, single rows and columns, and an
+        # empty inner dimension
+        for (m, k, n) in (
+            (37, 70, 33),
+            (33, 65, 31),
+            (1, 70, 40),
+            (40, 70, 1),
+            (1, 33, 1),
+            (5, 0, 7),
+        )
+    )
+    def test_matmul(self, run_eagerly, m, k, n):
+        rng = np.random.RandomState(42)
+        x_rows = [
+            [int(v) * 2 ** 90 - 5 for v in row] for row in rng.randint(-9, 9, (m, k))
+        ]
+        y_rows = [
+            [int(v) * 3 ** 40 for v in row] for row in rng.randint(-9, 9, (k, n))
+        ]
+        z_rows = [
+            [sum(x_rows[i][t] * y_rows[t][j] for t in range(k)) for j in range(n)]
+            for i in range(m)
+        ]
+        modulus = 2 ** 127 - 1
+
+        def as_array(rows, shape):
+            a = np.empty(shape, dtype=object)
+            for i, row in enumerate(rows):
+                a[i, :] = row
+            return a
+
+        x_raw = as_array(x_rows, (m, k))
+        y_raw = as_array(y_rows, (k, n))
+        z_raw = as_array(z_rows, (m, n))
+        z_mod_raw = as_array([[v % modulus for v in row] for row in z_rows], (m, n))
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            y = import_tensor(y_raw, storage="limbs")
+            z = x.matmul(y)
+            assert z.shape.as_list() == [m, n], z.shape
+            z_mod = x.matmul_mod(y, import_tensor(np.array([[modulus]])))
+
+            z = export_tensor(z)
+            z_mod = export_tensor(z_mod)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+        np.testing.assert_array_equal(
+            context.evaluate(z_mod).astype(str), z_mod_raw.astype(str)
+        )
+
+
+class StorageTest(parameterized.TestCase):
+    @parameterized.parameters(
+        {
+            "run_eagerly": run_eagerly,
+            "op": op,
+            "x_storage": x_storage,
+            "y_storage": y_storage,
+        }
+        for run_eagerly in (True, False)
+        for op in (lambda x, y: x + y, lambda x, y: x - y, lambda x, y: x * y)
+        for x_storage in ("mpz", "limbs")
+        for y_storage in ("mpz", "limbs")
+    )
+    def test_op(self, run_eagerly, op, x_storage, y_storage):
+        x_raw = np.array([[2 ** 130 + 7, -(2 ** 64), 0], [5, -(2 ** 200), 1]])
+        y_raw = np.array([[-(2 ** 130), 2 ** 64, 3], [-5, 2 ** 199, 2 ** 300]])
+        z_raw = op(x_raw, y_raw)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw, storage=x_storage)
+            y = import_tensor(y_raw, storage=y_storage)
+            z = op(x, y)
+
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "storage": storage}
+        for run_eagerly in (True, False)
+        for storage in ("mpz", "limbs")
+    )
+    def test_serialize(self, run_eagerly, storage):
+        x_raw = np.array([[2 ** 130 + 7, -(2 ** 64), 0], [5, -(2 ** 200), 1]])
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw, storage=storage)
+            serialized = tf.io.serialize_tensor(x._raw)
+            y = Tensor(tf.io.parse_tensor(serialized, out_type=tf.variant))
+            y = export_tensor(y)
+
+        np.testing.assert_array_equal(
+            context.evaluate(y).astype(str), x_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "header": header, "valid": valid}
+        for run_eagerly in (True, False)
+        for header, valid in (
+            # version, storage (limbs), rows, cols, width
+            ([1, 1, 1, 1, 0], True),
+            ([1, 1, 1, 1, 2 ** 60], False),
+            ([1, 1, 1, 1, -1], False),
+            ([1, 0, 1, 1, 1], False),
+            ([1, 1, 2 ** 32, 2 ** 32, 0], False),
+        )
+    )
+    def test_deserialize_malformed(self, run_eagerly, header, valid):
+        # A single zero, encoded by hand so that the header can be corrupted.
+        proto = tensor_pb2.TensorProto(
+            dtype=types_pb2.DT_VARIANT, tensor_shape=tf.TensorShape([]).as_proto()
+        )
+        data = proto.variant_val.add()
+        data.type_name = "BigTensor"
+        data.tensors.extend(
+            [
+                tf.make_tensor_proto(np.array(header, dtype=np.int64)),
+                tf.make_tensor_proto(np.array([0], dtype=np.int32)),
+                tf.make_tensor_proto(np.array([], dtype=np.uint64)),
+            ]
+        )
+        serialized = proto.SerializeToString()
+
+        def parse():
+            context = tf_execution_context(run_eagerly)
+            with context.scope():
+                y = Tensor(tf.io.parse_tensor(serialized, out_type=tf.variant))
+                y = export_tensor(y)
+            return context.evaluate(y)
+
+        if valid:
+            np.testing.assert_array_equal(parse().astype(str), np.array([["0"]]))
+        else:
+            with self.assertRaises(tf.errors.InvalidArgumentError):
+                parse()
+
+    def test_import_big_tensor(self):
+        x = import_tensor(np.array([[1, 2]]), storage="limbs")
+        self.assertIs(import_tensor(x), x)
+        with self.assertRaises(ValueError):
+            import_tensor(x, storage="mpz")
+
 
 class NumberTheoryTest(parameterized.TestCase):
     @parameterized.parameters(
@@ -190,6 +505,426 @@ class NumberTheoryTest(parameterized.TestCase):
             context.evaluate(y).astype(str), y_raw.astype(str)
         )
 
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_inv_batched(self, run_eagerly):
+        n = (2 ** 61 - 1) * (2 ** 31 - 1)
+        rng = np.random.RandomState(7)
+        # Zero, multiples of the modulus and of its factors have no inverse.
+        values = [int(v) * 12345678987654321 for v in rng.randint(-99, 99, 500)]
+        values[:4] = [0, 2 * n, 5 * (2 ** 31 - 1), n + 1]
+        # and some further in, so that batches are split around them
+        values[250] = 3 * (2 ** 61 - 1)
+        values[497] = -(2 ** 31 - 1)
+        x_raw = np.array(values).reshape((25, 20))
+
+        def inv(a):
+            try:
+                return int.__pow__(int(a), -1, n)
+            except ValueError:
+                return 0
+
+        y_raw = np.vectorize(inv, otypes=[object])(x_raw)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            y = x.inv(import_tensor(np.array([[n]])), batched=True)
+            y = export_tensor(y)
+
+        np.testing.assert_array_equal(
+            context.evaluate(y).astype(str), y_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_fused_mod(self, run_eagerly):
+        x_raw = np.array([[123456789123456789123456789], [-987654321987654321]])
+        y_raw = np.array([[55555555555555555555, 3]])
+        n = 1000000007
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            y = import_tensor(y_raw)
+            n_big = import_tensor(np.array([[n]]))
+            z_mul = export_tensor(x.mul_mod(y, n_big))
+            z_add = export_tensor(x.add_mod(y, n_big))
+            z_sub = export_tensor(x.sub_mod(y, n_big))
+
+        for z, op in [
+            (z_mul, lambda a, b: a * b),
+            (z_add, lambda a, b: a + b),
+            (z_sub, lambda a, b: a - b),
+        ]:
+            expected = np.array(
+                [[op(int(a), int(b)) % n for b in y_raw[0]] for a in x_raw[:, 0]]
+            )
+            np.testing.assert_array_equal(
+                context.evaluate(z).astype(str), expected.astype(str)
+            )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "n": n}
+        for run_eagerly in (True, False)
+        # odd moduli large enough to be batched where the CPU allows, and an
+        # even one that never is
+        for n in (2 ** 1279 - 1, 2 ** 2203 - 1, 2 ** 1024)
+    )
+    def test_batched(self, run_eagerly, n):
+        # 22 elements, so that batches of four or eight lanes end part-full, and
+        # a negative exponent that sends some batches back to GMP
+        row = [3 ** (50 * i) * (-1) ** i for i in range(9)] + [n - 1, n + 5]
+        x_raw = np.array([row, [x + 2 for x in row]])
+        y_raw = np.array([row[::-1]])
+        e_raw = np.array([[-1, 0, 1, 2, 3, 65537, 2 ** 200 + 1, n - 2, 12345, 7, 5]])
+
+        def expected(f, a, b):
+            return np.vectorize(f, otypes=[object])(a, b)
+
+        # `pow` is tf_big's here, so use int's three-argument form directly.
+        z_pow_raw = expected(lambda x, e: int.__pow__(x, e, n), x_raw, e_raw)
+        z_mul_raw = expected(lambda x, y: x * y % n, x_raw, y_raw)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = import_tensor(x_raw)
+            n_big = import_tensor(np.array([[n]]))
+            # only non-secure exponentiations are batched
+            e = import_tensor(e_raw)
+            z_pow = export_tensor(pow(x, e, n_big, secure=False))
+            z_mul = export_tensor(x.mul_mod(import_tensor(y_raw), n_big))
+
+        np.testing.assert_array_equal(
+            context.evaluate(z_pow).astype(str), z_pow_raw.astype(str)
+        )
+        np.testing.assert_array_equal(
+            context.evaluate(z_mul).astype(str), z_mul_raw.astype(str)
+        )
+
+
+class ReduceTest(parameterized.TestCase):
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "axis": axis, "storage": storage}
+        for run_eagerly in (True, False)
+        for axis in (None, 0, 1, -1)
+        for storage in ("mpz", "limbs")
+    )
+    def test_reduce_sum(self, run_eagerly, axis, storage):
+        x_raw = np.array(
+            [[2 ** 100, -3, 5 ** 60], [7, 2 ** 64 - 1, -(11 ** 30)], [1, 2, 3]]
+        )
+        z_raw = np.sum(x_raw, axis=axis, keepdims=True)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw, storage=storage)
+            z = reduce_sum(x, axis=axis)
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "axis": axis}
+        for run_eagerly in (True, False)
+        for axis in (None, 0, 1)
+    )
+    def test_reduce_prod_mod(self, run_eagerly, axis):
+        # Enough elements to be split across several chunks per reduction.
+        m_raw = 2 ** 127 - 1
+        x_raw = np.array(
+            [[(i * 7919 + j * 104729 + 1) ** 5 for j in range(40)] for i in range(30)],
+            dtype=object,
+        )
+        z_raw = np.prod(x_raw, axis=axis, keepdims=True) % m_raw
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(x_raw)
+            m = import_tensor(np.array([[m_raw]]))
+            z = reduce_prod_mod(x, m, axis=axis)
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+
+class LayoutTest(parameterized.TestCase):
+    x_raw = np.array(
+        [
+            [2 ** 100, -3, 5 ** 60, 7],
+            [11, 2 ** 64 - 1, -(13 ** 30), 0],
+            [1, 2, 3, 3 ** 90],
+        ]
+    )
+
+    def assert_op(self, run_eagerly, storage, op, z_raw):
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(self.x_raw, storage=storage)
+            z = op(x)
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "storage": storage}
+        for run_eagerly in (True, False)
+        for storage in ("mpz", "limbs")
+    )
+    def test_slice(self, run_eagerly, storage):
+        self.assert_op(
+            run_eagerly,
+            storage,
+            lambda x: slice(x, [1, 1], [2, -1]),
+            self.x_raw[1:, 1:],
+        )
+        # Slicing everything shares the storage of the input.
+        self.assert_op(
+            run_eagerly, storage, lambda x: slice(x, [0, 0], [3, 4]), self.x_raw
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "storage": storage, "axis": axis}
+        for run_eagerly in (True, False)
+        for storage in ("mpz", "limbs")
+        for axis in (0, 1)
+    )
+    def test_gather(self, run_eagerly, storage, axis):
+        indices = [2, 0, 0, 1] if axis == 0 else [3, 1]
+        self.assert_op(
+            run_eagerly,
+            storage,
+            lambda x: gather(x, indices, axis=axis),
+            np.take(self.x_raw, indices, axis=axis),
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "storage": storage, "axis": axis}
+        for run_eagerly in (True, False)
+        for storage in ("mpz", "limbs")
+        for axis in (0, 1, -1)
+    )
+    def test_concat(self, run_eagerly, storage, axis):
+        if axis == 0:
+            y_raw = np.array([[4, 2 ** 70, 6, -8]])
+        else:
+            y_raw = np.array([[4], [2 ** 70], [-8]])
+        z_raw = np.concatenate([self.x_raw, y_raw, self.x_raw], axis=axis)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+
+            x = import_tensor(self.x_raw, storage=storage)
+            y = import_tensor(y_raw, storage=storage)
+            z = concat([x, y, x], axis=axis)
+            z = export_tensor(z)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "storage": storage, "shape": shape}
+        for run_eagerly in (True, False)
+        for storage in ("mpz", "limbs")
+        for shape in ([2, 6], [12, 1], [1, -1], [-1, 3], [3, 4])
+    )
+    def test_reshape(self, run_eagerly, storage, shape):
+        self.assert_op(
+            run_eagerly,
+            storage,
+            lambda x: reshape(x, shape),
+            self.x_raw.reshape(shape),
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "storage": storage}
+        for run_eagerly in (True, False)
+        for storage in ("mpz", "limbs")
+    )
+    def test_transpose(self, run_eagerly, storage):
+        self.assert_op(run_eagerly, storage, transpose, self.x_raw.T)
+
+
+class MontgomeryTest(parameterized.TestCase):
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "n": n}
+        for run_eagerly in (True, False)
+        # one to nine limbs, covering fixed-width kernels and the mpn fallback
+        for n in (
+            2 ** 61 - 1,
+            2 ** 127 - 1,
+            2 ** 255 - 19,
+            2 ** 383 - 187,
+            2 ** 511 + 111,
+            2 ** 521 - 1,
+        )
+    )
+    def test_chain(self, run_eagerly, n):
+        x_raw = np.array([[3, 2 ** 200 + 1], [n - 1, 12345678901234567890]])
+        y_raw = np.array([[5, 2 ** 254], [n + 7, 1]])
+        e_raw = np.array([[0, 65537], [2 ** 100, 3]])
+
+        def expected(x, y, e):
+            # `pow` is tf_big's here, so use int's three-argument form directly.
+            return (int.__pow__(x * y % n, e, n) + x - y) % n
+
+        z_raw = np.vectorize(expected, otypes=[object])(x_raw, y_raw, e_raw)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = to_montgomery(x_raw, n)
+            y = to_montgomery(y_raw, n)
+            z = montgomery_pow(montgomery_mul(x, y, n), e_raw, n)
+            z = montgomery_sub(montgomery_add(z, x, n), y, n)
+            z = export_tensor(from_montgomery(z, n))
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+
+class FixedBaseTest(parameterized.TestCase):
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "window": window}
+        for run_eagerly in (True, False)
+        for window in (1, 4, 5)
+    )
+    def test_pow(self, run_eagerly, window):
+        n = (2 ** 127 - 1) ** 2
+        g = 2 ** 127
+        # the last exponent is longer than the table and takes the slow path
+        e_raw = np.array([[0, 1, 65537], [2 ** 126 + 5, 2 ** 127 - 2, 2 ** 300]])
+        z_raw = np.vectorize(lambda e: int.__pow__(g, e, n), otypes=[object])(e_raw)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            table = FixedBaseTable(g, n, max_bitlen=128, window=window)
+            z = export_tensor(table.pow(e_raw))
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), z_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "max_bitlen": max_bitlen, "window": window}
+        for run_eagerly in (True, False)
+        for max_bitlen, window in ((128, 0), (128, 30), (2 ** 31 - 1, 8))
+    )
+    def test_rejects_oversized_table(self, run_eagerly, max_bitlen, window):
+        n = (2 ** 127 - 1) ** 2
+
+        context = tf_execution_context(run_eagerly)
+        with self.assertRaises(tf.errors.InvalidArgumentError):
+            with context.scope():
+                table = FixedBaseTable(3, n, max_bitlen=max_bitlen, window=window)
+                z = export_tensor(table.pow([[1]]))
+            context.evaluate(z)
+
+
+class ObfuscatorPoolTest(parameterized.TestCase):
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "capacity": capacity}
+        for run_eagerly in (True, False)
+        for capacity in (1, 64)
+    )
+    def test_pop(self, run_eagerly, capacity):
+        p = 2 ** 89 - 1
+        q = 2 ** 107 - 1
+        n = p * q
+        nn = n * n
+        lam = (p - 1) * (q - 1) // math.gcd(p - 1, q - 1)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            pool = ObfuscatorPool(n, capacity=capacity)
+            x = export_tensor(pool.pop([3, 4]))
+            y = export_tensor(pool.pop([2, 1]))
+
+        x = context.evaluate(x)
+        y = context.evaluate(y)
+        self.assertEqual(x.shape, (3, 4))
+        self.assertEqual(y.shape, (2, 1))
+        self.assertEqual(len(set(x.flatten())), 12)
+        # every obfuscator is an n-th power, so its order divides lambda(n)
+        for v in np.concatenate([x.flatten(), y.flatten()]):
+            v = int(v)
+            self.assertTrue(0 < v < nn)
+            self.assertEqual(int.__pow__(v, lam, nn), 1)
+
+
+class CountersTest(parameterized.TestCase):
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_kernel_counters(self, run_eagerly):
+        def read_counters():
+            with context.scope():
+                counters = kernel_counters()
+            counters = context.evaluate(counters)
+            ops = [op.decode() for op in counters["op"]]
+            return {
+                key: dict(zip(ops, values))
+                for key, values in counters.items()
+                if key != "op"
+            }
+
+        context = tf_execution_context(run_eagerly)
+        before = read_counters()
+
+        with context.scope():
+            x = import_tensor(np.array([[1, 2, 3], [4, 5, 6]]))
+            z = export_tensor(x * x)
+        context.evaluate(z)
+
+        after = read_counters()
+        self.assertEqual(
+            after["calls"]["BigMul"] - before["calls"].get("BigMul", 0), 1
+        )
+        self.assertEqual(
+            after["elements"]["BigMul"] - before["elements"].get("BigMul", 0), 6
+        )
+        self.assertGreater(after["limb_ops"]["BigMul"], 0)
+        self.assertGreater(after["wall_nanos"]["BigMul"], 0)
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_gmp_memory_stats(self, run_eagerly):
+        context = tf_execution_context(run_eagerly)
+
+        with context.scope():
+            before = gmp_memory_stats()
+        before = context.evaluate(before)
+
+        with context.scope():
+            x = import_tensor(np.array([[1, 2, 3], [4, 5, 6]]))
+            z = export_tensor(x * x + x)
+        context.evaluate(z)
+
+        with context.scope():
+            after = gmp_memory_stats()
+        after = context.evaluate(after)
+
+        self.assertGreater(after["allocations"], before["allocations"])
+        self.assertGreater(after["bytes_allocated"], before["bytes_allocated"])
+        self.assertGreaterEqual(after["pool_hits"], before["pool_hits"])
+        self.assertGreaterEqual(after["bytes_in_use"], 0)
+        self.assertGreaterEqual(after["bytes_cached"], 0)
+
 
 class ConvertTest(parameterized.TestCase):
     @parameterized.parameters(
@@ -286,6 +1021,85 @@ class ConvertTest(parameterized.TestCase):
 
         assert y.dtype is tf.string
 
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "string_format": string_format}
+        for run_eagerly in (True, False)
+        for string_format in ("decimal", "hex", "bytes")
+    )
+    def test_string_format(self, run_eagerly, string_format):
+        x_raw = np.array([[0, 1, 255], [256, 2 ** 64, 3 ** 100]])
+
+        def encode(v):
+            v = int(v)
+            if string_format == "hex":
+                return "{:x}".format(v)
+            if string_format == "bytes":
+                return v.to_bytes((v.bit_length() + 7) // 8, "big")
+            return str(v)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = import_tensor(x_raw)
+            y = export_tensor(x, string_format=string_format)
+            z = import_tensor(y, storage="limbs", string_format=string_format)
+            z = export_tensor(z)
+
+        y_expected = np.vectorize(encode, otypes=[object])(x_raw)
+        y_actual = context.evaluate(y)
+        for actual, expected in zip(y_actual.flatten(), y_expected.flatten()):
+            if string_format != "bytes":
+                expected = expected.encode()
+            assert actual == expected, (actual, expected)
+
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), x_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly, "tf_type": tf_type, "storage": storage}
+        for run_eagerly in (True, False)
+        for tf_type in (tf.int64, tf.uint64)
+        for storage in ("mpz", "limbs")
+    )
+    def test_integer_conversion(self, run_eagerly, tf_type, storage):
+        np_type = tf_type.as_numpy_dtype
+        info = np.iinfo(np_type)
+        x_raw = np.array([[info.min, 0, 1], [2 ** 40 + 3, info.max - 1, info.max]])
+        x_raw = x_raw.astype(np_type)
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = import_tensor(tf.constant(x_raw), storage=storage)
+            y = export_tensor(x, dtype=tf_type, checked=True)
+            z = export_tensor(x)
+
+        np.testing.assert_array_equal(context.evaluate(y), x_raw)
+        np.testing.assert_array_equal(
+            context.evaluate(z).astype(str), x_raw.astype(str)
+        )
+
+    @parameterized.parameters(
+        {"run_eagerly": run_eagerly} for run_eagerly in (True, False)
+    )
+    def test_integer_overflow(self, run_eagerly):
+        x_raw = np.array([[2 ** 63, -(2 ** 63) - 1, 2 ** 64 + 5]])
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = import_tensor(x_raw)
+            wrapped = export_tensor(x, dtype=tf.int64)
+
+        np.testing.assert_array_equal(
+            context.evaluate(wrapped),
+            np.array([[-(2 ** 63), 2 ** 63 - 1, 5]], dtype=np.int64),
+        )
+
+        with self.assertRaises(tf.errors.InvalidArgumentError):
+            with context.scope():
+                x = import_tensor(x_raw)
+                checked = export_tensor(x, dtype=tf.int64, checked=True)
+            context.evaluate(checked)
+
     @parameterized.parameters(
         {
             "run_eagerly": run_eagerly,
@@ -331,6 +1145,45 @@ class ConvertTest(parameterized.TestCase):
             context.evaluate(res).astype(str), np.array([["40", "60"]])
         )
 
+    @parameterized.parameters(
+        {
+            "run_eagerly": run_eagerly,
+            "tf_type": tf_type,
+            "layout": layout,
+            "storage": storage,
+        }
+        for run_eagerly in (True, False)
+        for tf_type in (tf.uint8, tf.int32, tf.int64, tf.uint32, tf.uint64)
+        for layout in ("header", "fixed")
+        for storage in ("mpz", "limbs")
+    )
+    def test_limb_layout(self, run_eagerly, tf_type, layout, storage):
+        x_raw = np.array([[0, 1, 2 ** 32], [2 ** 64 - 1, 2 ** 64 + 7, 3 ** 100]])
+        max_bitlen = 160
+
+        context = tf_execution_context(run_eagerly)
+        with context.scope():
+            x = import_tensor(x_raw)
+            x_limbs = export_limbs_tensor(
+                x, dtype=tf_type, max_bitlen=max_bitlen, layout=layout
+            )
+            y = import_limbs_tensor(x_limbs, storage=storage, layout=layout)
+            y = export_tensor(y)
+
+        x_limbs = context.evaluate(x_limbs)
+        header_bits = 32 if layout == "header" else 0
+        type_bits = tf_type.size * 8
+        num_words = (header_bits + max_bitlen + type_bits - 1) // type_bits
+        assert x_limbs.shape == (2, 3, num_words), x_limbs.shape
+        if layout == "fixed" and tf_type in (tf.int64, tf.uint64):
+            # each word is a limb, least significant first
+            assert x_limbs[0, 2, 0] == 2 ** 32, x_limbs[0, 2]
+            assert x_limbs[1, 1, 1] == 1, x_limbs[1, 1]
+
+        np.testing.assert_array_equal(
+            context.evaluate(y).astype(str), x_raw.astype(str)
+        )
+
 
 if __name__ == "__main__":
     unittest.main()